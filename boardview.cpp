@@ -0,0 +1,470 @@
+/*
+ * @file boardview.cpp
+ * @brief contains class definition of BoardView class
+ *
+ * The view is an origin (where square (0,0) is drawn, in pixels) and a
+ * square size. Zooming changes the size while keeping the square under the
+ * mouse still; dragging moves the origin. Both are kept so the board never
+ * leaves the view, and is centred when it is smaller than the view.
+ */
+
+#include "boardview.h"
+#include "gameengine.h"
+#include "trace.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QPen>
+#include <cmath>
+#include <cstring>
+
+//biggest square size, in pixels, when zoomed all the way in
+static const qreal max_side = 96;
+
+//past this many changed squares, redraw everything instead of each square
+static const int max_square_updates = 256;
+
+/*
+ * Function to get where the mouse is. pos() is deprecated from Qt 6 on,
+ * where position() takes its place.
+ */
+static QPoint mouse_at(const QMouseEvent *e)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return e->position().toPoint();
+#else
+    return e->pos();
+#endif
+}
+
+/*
+ * Constructor for the BoardView class. Every square starts empty and the
+ * whole board is in view.
+ *
+ * @param board_sz is number of squares along each side of the board
+ * @param th gives the colours of the squares
+ * @param parent is the widget the board is in
+ */
+BoardView::BoardView(size_t board_sz, const Theme& th, QWidget *parent) :
+    QWidget(parent), board_size(board_sz), theme(th), origin(0, 0), side(0),
+    shown(board_sz*board_sz, 0), scaled_side(0)
+{
+    //arrow keys are for the bee, not for this widget
+    setFocusPolicy(Qt::NoFocus);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(500, 500);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    //each level is half the size of the one before, down to one pixel
+    size_t n = board_size;
+    while(true)
+    {
+        pyramid.push_back(QImage(n, n, QImage::Format_RGB32));
+        if(n == 1)
+            break;
+        n = (n + 1) / 2;
+    }
+    build_pyramid();
+}
+
+/*
+ * Function to set the picture drawn for a piece when zoomed in.
+ *
+ * @param piece is a GameEngine::Piece
+ * @param image is the picture, any size
+ */
+void BoardView::set_picture(int piece, const QPixmap& image)
+{
+    pictures[piece] = image;
+    scaled_side = 0;
+    update();
+}
+
+/*
+ * Function to work out a pixel of a level above 0 from the (up to) four
+ * pixels under it.
+ */
+static QRgb average(const QImage& below, int x, int y)
+{
+    int r = 0, g = 0, b = 0, count = 0;
+    for(int cy = 2*y; cy <= 2*y + 1 && cy < below.height(); cy++)
+    {
+        const QRgb* row = reinterpret_cast<const QRgb*>(below.constScanLine(cy));
+        for(int cx = 2*x; cx <= 2*x + 1 && cx < below.width(); cx++)
+        {
+            r += qRed(row[cx]);
+            g += qGreen(row[cx]);
+            b += qBlue(row[cx]);
+            count++;
+        }
+    }
+    return qRgb(r / count, g / count, b / count);
+}
+
+/*
+ * Function to work out every level of the pyramid from what is shown.
+ */
+void BoardView::build_pyramid()
+{
+    for(size_t y = 0; y < board_size; y++)
+    {
+        QRgb* row = reinterpret_cast<QRgb*>(pyramid[0].scanLine(y));
+        for(size_t x = 0; x < board_size; x++)
+            row[x] = theme.piece_colors[shown[y*board_size + x]].rgb();
+    }
+
+    for(size_t level = 1; level < pyramid.size(); level++)
+    {
+        QImage& image = pyramid[level];
+        for(int y = 0; y < image.height(); y++)
+        {
+            QRgb* row = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for(int x = 0; x < image.width(); x++)
+                row[x] = average(pyramid[level - 1], x, y);
+        }
+    }
+}
+
+/*
+ * Function to change one square, and the pixel covering it on each level.
+ */
+void BoardView::set_square(int x, int y, uint8_t piece)
+{
+    shown[y*board_size + x] = piece;
+    reinterpret_cast<QRgb*>(pyramid[0].scanLine(y))[x] = theme.piece_colors[piece].rgb();
+
+    for(size_t level = 1; level < pyramid.size(); level++)
+    {
+        x /= 2;
+        y /= 2;
+        reinterpret_cast<QRgb*>(pyramid[level].scanLine(y))[x] = average(pyramid[level - 1], x, y);
+    }
+}
+
+/*
+ * Function to show what is in each square now, looking at every row.
+ *
+ * @param pieces is the GameEngine::Piece in each square, row by row
+ */
+void BoardView::set_pieces(const std::vector<uint8_t>& pieces)
+{
+    set_pieces(pieces, std::vector<uint64_t>(), 0);
+}
+
+/*
+ * Function to show what is in each square now. Squares that are the same
+ * as before cost almost nothing; eight at a time are compared at once.
+ * Rows that haven't changed since the pieces last given aren't looked at,
+ * as comparing every square of a 4096x4096 board takes a few milliseconds.
+ *
+ * @param pieces is the GameEngine::Piece in each square, row by row
+ * @param row_changed is when each row last changed, or empty to look at
+ * every row
+ * @param since is when the pieces last given were from
+ */
+void BoardView::set_pieces(const std::vector<uint8_t>& pieces, const std::vector<uint64_t>& row_changed, uint64_t since)
+{
+    TRACE_SCOPE("set_pieces");
+
+    if(pieces.size() != shown.size())
+        return;
+    bool every_row = row_changed.size() != board_size;
+
+    const uint8_t* now = pieces.data();
+    QRect changed;
+    int updates = 0;
+
+    for(size_t y = 0; y < board_size; y++)
+    {
+        if(!every_row && row_changed[y] <= since)
+            continue;
+
+        for(size_t pos = y*board_size, end = pos + board_size; pos < end; )
+        {
+            if(end - pos >= 8 && std::memcmp(now + pos, &shown[pos], 8) == 0)
+            {
+                pos += 8;
+                continue;
+            }
+
+            if(now[pos] != shown[pos])
+            {
+                int x = pos % board_size;
+                set_square(x, y, now[pos]);
+                changed |= QRect(x, y, 1, 1);
+                if(++updates <= max_square_updates)
+                    update(square_rect(x, y));
+            }
+            pos++;
+        }
+    }
+
+    if(updates > max_square_updates)
+        update();
+    if(!changed.isNull())
+        emit squares_changed(changed);
+}
+
+/*
+ * Function to show swarm mode's workers. Workers move every tick, so the
+ * whole board is redrawn.
+ *
+ * @param squares is the square each worker is in
+ */
+void BoardView::set_workers(const std::vector<Cell>& squares)
+{
+    if(squares.empty() && workers.empty())
+        return;
+    workers = squares;
+    update();
+}
+
+/*
+ * Function to draw the workers in squares x0 to x1, y0 to y1 as dots a
+ * third of a square across, or a pixel when squares are smaller than that.
+ */
+void BoardView::draw_workers(QPainter& painter, int x0, int x1, int y0, int y1)
+{
+    if(workers.empty())
+        return;
+
+    worker_points.clear();
+    for(size_t i = 0, n = workers.size(); i < n; i++)
+    {
+        const Cell& w = workers[i];
+        if(w.x >= x0 && w.x <= x1 && w.y >= y0 && w.y <= y1)
+            worker_points.append(QPointF(origin.x() + (w.x + 0.5)*side, origin.y() + (w.y + 0.5)*side));
+    }
+
+    painter.setPen(QPen(theme.worker_color, qMax(qreal(1), side / 3), Qt::SolidLine, Qt::SquareCap));
+    painter.drawPoints(worker_points);
+}
+
+/*
+ * Function to set the image drawn over the board.
+ *
+ * @param image has one pixel per square, or is null for no overlay
+ */
+void BoardView::set_overlay(const QImage& image)
+{
+    if(image.isNull() && overlay.isNull())
+        return;
+    overlay = image;
+    update();
+}
+
+/*
+ * Function to draw the part of the overlay over squares x0 to x1, y0 to y1.
+ */
+void BoardView::draw_overlay(QPainter& painter, int x0, int x1, int y0, int y1)
+{
+    if(overlay.isNull())
+        return;
+
+    QRectF source(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+    QRectF target(origin.x() + x0*side, origin.y() + y0*side, source.width()*side, source.height()*side);
+    painter.drawImage(target, overlay, source);
+}
+
+/*
+ * Function to find the pixels covered by a square.
+ */
+QRect BoardView::square_rect(int x, int y) const
+{
+    return QRectF(origin.x() + x*side, origin.y() + y*side, side, side).toAlignedRect();
+}
+
+/*
+ * Function to find the square size that fits the whole board in view.
+ */
+qreal BoardView::fit_side() const
+{
+    return qreal(qMin(width(), height())) / board_size;
+}
+
+/*
+ * Function to change the view. The square size is kept between fitting the
+ * whole board and max_side, and the board is kept in view.
+ *
+ * @param new_origin is where square (0,0) should be drawn
+ * @param new_side is how big squares should be
+ */
+void BoardView::set_view(QPointF new_origin, qreal new_side)
+{
+    qreal fit = fit_side();
+    new_side = qBound(fit, new_side, qMax(fit, max_side));
+
+    qreal content = new_side*board_size;
+    if(content <= width())
+        new_origin.setX((width() - content) / 2);
+    else
+        new_origin.setX(qBound(width() - content, new_origin.x(), qreal(0)));
+    if(content <= height())
+        new_origin.setY((height() - content) / 2);
+    else
+        new_origin.setY(qBound(height() - content, new_origin.y(), qreal(0)));
+
+    origin = new_origin;
+    side = new_side;
+    update();
+    emit view_changed(origin, side);
+}
+
+/*
+ * Function to zoom all the way out.
+ */
+void BoardView::fit()
+{
+    set_view(QPointF(0, 0), 0);
+}
+
+/*
+ * Function to centre the view on a point.
+ *
+ * @param square is the point, in squares from the board's top left corner
+ */
+void BoardView::look_at(const QPointF& square)
+{
+    set_view(QPointF(width() / 2.0, height() / 2.0) - square*side, side);
+}
+
+/*
+ * Function to keep the view inside the board when the widget changes size.
+ * A board that was all in view stays all in view.
+ */
+void BoardView::resizeEvent(QResizeEvent *e)
+{
+    bool fitted = side <= qreal(qMin(e->oldSize().width(), e->oldSize().height())) / board_size;
+    if(fitted || side == 0)
+        fit();
+    else
+        set_view(origin, side);
+}
+
+/*
+ * Function to zoom in or out around the mouse. One notch of the wheel is a
+ * fifth of a doubling.
+ */
+void BoardView::wheelEvent(QWheelEvent *e)
+{
+    //QWheelEvent::pos() is deprecated from Qt 5.14 on
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    QPointF at = e->position();
+#else
+    QPointF at = e->pos();
+#endif
+    QPointF square = (at - origin) / side;
+    qreal new_side = side*std::pow(2.0, e->angleDelta().y() / 600.0);
+
+    set_view(at - square*new_side, new_side);
+    e->accept();
+}
+
+void BoardView::mousePressEvent(QMouseEvent *e)
+{
+    drag_from = mouse_at(e);
+}
+
+/*
+ * Function to pan by dragging with the mouse.
+ */
+void BoardView::mouseMoveEvent(QMouseEvent *e)
+{
+    if(!(e->buttons() & Qt::LeftButton))
+        return;
+
+    QPoint at = mouse_at(e);
+    set_view(origin + QPointF(at - drag_from), side);
+    drag_from = at;
+}
+
+/*
+ * Function to zoom all the way out on a double click.
+ */
+void BoardView::mouseDoubleClickEvent(QMouseEvent *e)
+{
+    Q_UNUSED(e);
+    fit();
+}
+
+/*
+ * Function to draw the part of the board that needs it, with pictures,
+ * flat colours or average colours depending on how big squares are.
+ *
+ * @param e is QPaintEvent object called
+ */
+void BoardView::paintEvent(QPaintEvent *e)
+{
+    TRACE_SCOPE("BoardView::paintEvent");
+
+    QPainter painter(this);
+    QRect dirty = e->rect();
+    painter.fillRect(dirty, theme.outside_board);
+
+    QRectF board(origin, QSizeF(side*board_size, side*board_size));
+    QRect area = board.toAlignedRect().intersected(dirty);
+    if(area.isEmpty())
+        return;
+    painter.setClipRect(area);
+
+    //squares in the area
+    int last = board_size - 1;
+    int x0 = qBound(0, int(std::floor((area.left() - origin.x()) / side)), last);
+    int x1 = qBound(0, int(std::floor((area.right() + 1 - origin.x()) / side)), last);
+    int y0 = qBound(0, int(std::floor((area.top() - origin.y()) / side)), last);
+    int y1 = qBound(0, int(std::floor((area.bottom() + 1 - origin.y()) / side)), last);
+
+    if(pictures_shown())
+    {
+        painter.fillRect(area, theme.piece_colors[GameEngine::Empty]);
+
+        //pictures are scaled once per square size, not once per square
+        int s = qRound(side);
+        if(s != scaled_side)
+        {
+            for(int p = 0; p < 7; p++)
+            {
+                if(!pictures[p].isNull())
+                    scaled[p] = pictures[p].scaled(s, s, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            }
+            scaled_side = s;
+        }
+
+        for(int y = y0; y <= y1; y++)
+        {
+            for(int x = x0; x <= x1; x++)
+            {
+                //empty squares are already white; the bee and clouds are on the SpriteLayer
+                int p = shown[y*board_size + x];
+                if(p == GameEngine::Empty || p == GameEngine::Cloud || p == GameEngine::Bee || scaled[p].isNull())
+                    continue;
+
+                QRect r = square_rect(x, y);
+                if(r.size() == scaled[p].size())
+                    painter.drawPixmap(r.topLeft(), scaled[p]);
+                else
+                    painter.drawPixmap(r, scaled[p]);
+            }
+        }
+        draw_workers(painter, x0, x1, y0, y1);
+        draw_overlay(painter, x0, x1, y0, y1);
+        return;
+    }
+
+    //one pixel per square stretched, or one pixel per block of squares when
+    //squares are smaller than a pixel; no smoothing, so edges stay sharp
+    int level = 0;
+    if(side < 1)
+        level = qMin(int(pyramid.size()) - 1, int(std::floor(std::log2(1 / side))));
+    qreal block = side*(1 << level);
+
+    int sx0 = x0 >> level, sx1 = x1 >> level;
+    int sy0 = y0 >> level, sy1 = y1 >> level;
+    QRectF source(sx0, sy0, sx1 - sx0 + 1, sy1 - sy0 + 1);
+    QRectF target(origin.x() + sx0*block, origin.y() + sy0*block, source.width()*block, source.height()*block);
+    painter.drawImage(target, pyramid[level], source);
+    draw_workers(painter, x0, x1, y0, y1);
+    draw_overlay(painter, x0, x1, y0, y1);
+}
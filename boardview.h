@@ -0,0 +1,128 @@
+/*
+ * @file boardview.h
+ * @brief header file to contain BoardView class declarations
+ *
+ * This headerfile contains the class declaration of the BoardView class,
+ * the board itself: a widget that draws every square and can be zoomed with
+ * the mouse wheel and panned by dragging, so big boards stay readable.
+*/
+
+#ifndef BOARDVIEW_H
+#define BOARDVIEW_H
+
+#include "gameengine.h"
+#include "theme.h"
+#include <QWidget>
+#include <QPixmap>
+#include <QImage>
+#include <QPointF>
+#include <QPolygonF>
+#include <cstdint>
+#include <vector>
+
+class QPainter;
+
+/*
+ * @class BoardView
+ * @brief draws the board at any zoom, with less detail the smaller
+ * squares get
+ *
+ * - squares at least sprite_side pixels: the pieces' pictures, scaled once
+ *   per square size. The bee and clouds are left to the SpriteLayer.
+ * - squares of 1 to sprite_side pixels: a flat colour per square, drawn by
+ *   stretching an image with one pixel per square.
+ * - squares under a pixel: the average colour of each block of squares,
+ *   from a pyramid of images each half the size of the one before.
+ *
+ * The pyramid is kept up to date one square at a time: a changed square
+ * sets its pixel, then each level above recomputes the one pixel covering
+ * it. Only changed squares are asked to be redrawn, and only drawing the
+ * part of the board in view costs anything, so panning a big board is as
+ * fast as a small one.
+ *
+ * Swarm mode's workers are drawn over the squares as dots, all in one
+ * call, however many there are. An overlay such as a heatmap can go over
+ * everything, stretched like the flat colours.
+ */
+class BoardView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit BoardView(size_t board_size, const Theme& theme, QWidget *parent = 0);
+
+    //picture drawn for a GameEngine::Piece when zoomed in
+    void set_picture(int piece, const QPixmap& image);
+
+    //what is in each square (GameEngine::Piece), row by row
+    void set_pieces(const std::vector<uint8_t>& pieces);
+
+    //same, but only rows whose row_changed is after since are looked at;
+    //see Simulation::Frame
+    void set_pieces(const std::vector<uint8_t>& pieces, const std::vector<uint64_t>& row_changed, uint64_t since);
+
+    //squares of swarm mode's workers
+    void set_workers(const std::vector<Cell>& squares);
+
+    //image with one pixel per square drawn over the board, or a null image for none
+    void set_overlay(const QImage& image);
+
+    //where square (0,0) is drawn and how big squares are
+    QPointF view_origin() const { return origin; }
+    qreal square_side() const { return side; }
+    bool pictures_shown() const { return side >= sprite_side; }
+
+    //centre the view on a point, in squares
+    void look_at(const QPointF& square);
+
+    //zoom all the way out, so the whole board is in view
+    void fit();
+
+    //average colours, level 0 has one pixel per square
+    int levels() const { return pyramid.size(); }
+    const QImage& level(int i) const { return pyramid[i]; }
+
+    size_t get_board_size() const { return board_size; }
+
+    static const int sprite_side = 8; //smallest squares pictures are drawn at
+
+signals:
+    void view_changed(QPointF origin, qreal side);
+    void squares_changed(QRect squares);
+
+protected:
+    void paintEvent(QPaintEvent *e);
+    void resizeEvent(QResizeEvent *e);
+    void wheelEvent(QWheelEvent *e);
+    void mousePressEvent(QMouseEvent *e);
+    void mouseMoveEvent(QMouseEvent *e);
+    void mouseDoubleClickEvent(QMouseEvent *e);
+
+private:
+    void set_view(QPointF new_origin, qreal new_side);
+    qreal fit_side() const;
+    QRect square_rect(int x, int y) const;
+    void build_pyramid();
+    void set_square(int x, int y, uint8_t piece);
+    void draw_workers(QPainter& painter, int x0, int x1, int y0, int y1);
+    void draw_overlay(QPainter& painter, int x0, int x1, int y0, int y1);
+
+    size_t board_size;
+    const Theme& theme;
+
+    QPointF origin;
+    qreal side;
+    QPoint drag_from; //mouse position the last drag step started at
+
+    std::vector<uint8_t> shown; //what each square is drawn as
+    std::vector<Cell> workers;
+    QPolygonF worker_points; //reused by each paint
+    QImage overlay;
+    std::vector<QImage> pyramid;
+
+    QPixmap pictures[7];
+    QPixmap scaled[7]; //pictures at scaled_side
+    int scaled_side;
+};
+
+#endif // BOARDVIEW_H
@@ -0,0 +1,314 @@
+/*
+ * @file botserver.cpp
+ * @brief contains the bot server that plays the game over a Unix socket
+ *
+ * Each connection is handled on its own thread with its own GameEngine, so
+ * many bots can play at once. A Step message can hold thousands of moves,
+ * and the reply for all of them is sent in a single write. The limits in
+ * botserver.h keep one bot from using too much memory or holding a
+ * thread for long.
+ */
+
+#include "botserver.h"
+#include "gameengine.h"
+#include "planner.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//bots being served now, kept to botproto::max_clients
+static int clients = 0;
+static std::mutex clients_lock;
+static std::condition_variable client_done;
+
+/*
+ * Function to read exactly len bytes from a socket.
+ *
+ * @return false if the other end closed the connection or there was an error
+ */
+static bool read_all(int fd, void* buf, size_t len)
+{
+    char* p = static_cast<char*>(buf);
+    while(len > 0)
+    {
+        ssize_t n = ::read(fd, p, len);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/*
+ * Function to write all of buf to a socket.
+ *
+ * @return false if there was an error
+ */
+static bool write_all(int fd, const std::vector<char>& buf)
+{
+    const char* p = buf.data();
+    size_t len = buf.size();
+    while(len > 0)
+    {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/*
+ * Function to add a struct to the end of a reply.
+ */
+template <typename T>
+static void append(std::vector<char>& out, const T& value)
+{
+    const char* p = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+/*
+ * Function to describe the engine's current state as a Tick.
+ */
+static botproto::Tick make_tick(const GameEngine& engine)
+{
+    botproto::Tick t;
+    std::memset(&t, 0, sizeof(t));
+    t.bee_x = engine.bee().x;
+    t.bee_y = engine.bee().y;
+    t.flower_x = engine.flower().x;
+    t.flower_y = engine.flower().y;
+    t.cloud_x = -1;
+    t.cloud_y = -1;
+    if(!engine.clouds().empty())
+    {
+        t.cloud_x = engine.clouds()[0].x;
+        t.cloud_y = engine.clouds()[0].y;
+    }
+    t.progress = engine.get_progress();
+    if(engine.is_over())
+        t.flags |= botproto::Done;
+    return t;
+}
+
+/*
+ * Function to add squares to the end of a reply.
+ */
+static void append_cells(std::vector<char>& out, const std::vector<Cell>& cells)
+{
+    for(size_t i = 0, n = cells.size(); i < n; i++)
+        append(out, botproto::CellPos{static_cast<int16_t>(cells[i].x), static_cast<int16_t>(cells[i].y)});
+}
+
+/*
+ * Function to add the opps, obstacles, enemies and score to the end of a
+ * reply.
+ */
+static void append_board(std::vector<char>& out, const GameEngine& engine)
+{
+    botproto::BoardHeader h;
+    h.score = engine.get_score();
+    h.num_opps = engine.opps().size();
+    h.num_obstacles = engine.obstacle_cells().size();
+    h.num_enemies = engine.clouds().size();
+    append(out, h);
+
+    append_cells(out, engine.opps());
+    append_cells(out, engine.obstacle_cells());
+    append_cells(out, engine.clouds());
+}
+
+/*
+ * Function to play one tick: the bee moves, then the cloud moves.
+ *
+ * @param engine is the game being played
+ * @param action is the GameEngine::Move to make, or plan_action
+ * @param planner chooses the move for plan_action
+ * @return what the bot sees after the tick
+ */
+static botproto::Tick step_once(GameEngine& engine, uint8_t action, Planner& planner)
+{
+    if(engine.is_over())
+        return make_tick(engine);
+
+    if(action == botproto::plan_action)
+        action = planner.plan(engine, botproto::plan_us).move;
+
+    size_t score = engine.get_score();
+    size_t counter = engine.get_counter();
+    int bee_x = engine.bee().x;
+    int bee_y = engine.bee().y;
+
+    bool pressed = engine.press(static_cast<GameEngine::Move>(action));
+    if(engine.has_moving_enemies())
+        engine.move_enemy();
+
+    //nobody draws the board here, so don't keep a list of changed squares
+    engine.clear_changed();
+
+    botproto::Tick t = make_tick(engine);
+    if(engine.get_counter() != counter)
+        t.flags |= botproto::Picked;
+    if(engine.get_score() != score)
+    {
+        t.flags |= botproto::Deposited;
+        t.reward = 1;
+    }
+    if(pressed && engine.bee().x == bee_x && engine.bee().y == bee_y)
+        t.flags |= botproto::Blocked;
+    if(engine.is_over())
+        t.reward = -1;
+    return t;
+}
+
+/*
+ * Function to talk to one bot until it sends Close or disconnects.
+ *
+ * @param fd is the connected socket, closed when done
+ */
+static void serve_client(int fd)
+{
+    GameEngine* engine = 0;
+    Planner planner;
+    std::vector<char> out;
+    std::vector<uint8_t> actions;
+
+    uint8_t opcode;
+    while(read_all(fd, &opcode, 1))
+    {
+        out.clear();
+
+        if(opcode == botproto::Reset)
+        {
+            botproto::ResetRequest req;
+            if(!read_all(fd, &req, sizeof(req)))
+                break;
+            if(req.board_size < 2 || req.board_size > botproto::max_board || req.opp_time < 1)
+                break;
+
+            delete engine;
+            engine = new GameEngine(req.board_size, req.opp_time, req.moving_enemies != 0, req.obstacles != 0, req.seed);
+            engine->clear_changed();
+
+            append(out, make_tick(*engine));
+            append_board(out, *engine);
+        }
+        else if(opcode == botproto::Step)
+        {
+            uint32_t count;
+            if(!read_all(fd, &count, sizeof(count)) || count > botproto::max_step || !engine)
+                break;
+            actions.resize(count);
+            if(count > 0 && !read_all(fd, actions.data(), count))
+                break;
+
+            //planned moves are slow, so only so many in one Step
+            uint32_t planned = 0;
+            for(uint32_t i = 0; i < count; i++)
+                planned += actions[i] == botproto::plan_action;
+            if(planned > botproto::max_planned)
+                break;
+
+            out.reserve(sizeof(count) + count*sizeof(botproto::Tick));
+            append(out, count);
+            for(uint32_t i = 0; i < count; i++)
+                append(out, step_once(*engine, actions[i], planner));
+            append_board(out, *engine);
+        }
+        else
+        {
+            break;
+        }
+
+        if(!write_all(fd, out))
+            break;
+    }
+
+    delete engine;
+    ::close(fd);
+
+    {
+        std::lock_guard<std::mutex> guard(clients_lock);
+        clients--;
+    }
+    client_done.notify_one();
+}
+
+/*
+ * Function to run the bot server. Removes any old socket file at
+ * socket_path, listens there, and starts a thread for every connection.
+ * While max_clients bots are being served, new ones aren't accepted and
+ * wait in the listen queue.
+ *
+ * @param socket_path is the file name of the Unix domain socket
+ * @return 1 if the socket couldn't be set up, otherwise never returns
+ */
+int run_bot_server(const char* socket_path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(std::strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        std::fprintf(stderr, "bot server: socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    std::strcpy(addr.sun_path, socket_path);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0)
+    {
+        std::perror("bot server: socket");
+        return 1;
+    }
+
+    ::unlink(socket_path);
+    if(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listener, 64) < 0)
+    {
+        std::perror("bot server: bind");
+        ::close(listener);
+        return 1;
+    }
+
+    std::fprintf(stderr, "bot server: listening on %s\n", socket_path);
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(clients_lock);
+            client_done.wait(guard, [] { return clients < botproto::max_clients; });
+        }
+
+        int fd = ::accept(listener, 0, 0);
+        if(fd < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::perror("bot server: accept");
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(clients_lock);
+            clients++;
+        }
+        std::thread(serve_client, fd).detach();
+    }
+
+    ::close(listener);
+    return 1;
+}
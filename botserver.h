@@ -0,0 +1,103 @@
+/*
+ * @file botserver.h
+ * @brief header file to contain the bot server protocol and entry point
+ *
+ * The bot server lets other programs play the game without a window. It
+ * listens on a Unix domain socket and each connection gets its own
+ * GameEngine. Messages are fixed-size structs in the machine's own byte
+ * order, since both ends are always on the same machine.
+ *
+ * Client to server, each message starts with one opcode byte:
+ *   Reset: opcode, then a ResetRequest.     Reply: one Tick, then the board.
+ *   Step:  opcode, then a uint32_t count, then count action bytes (a
+ *          GameEngine::Move each, or plan_action to let the server's
+ *          planner choose). Every action is one tick: the bee moves,
+ *          then the cloud moves once if the level has one.
+ *          Reply: uint32_t count, count Ticks, then the board.
+ *   Close: opcode. The server closes the connection.
+ *
+ * "The board" is a BoardHeader followed by num_opps, then num_obstacles,
+ * then num_enemies CellPos entries, for the state after the last tick.
+ * Enemies are the clouds and any that scripts spawned; Tick only carries
+ * the first one.
+ *
+ * A request the server won't serve (a board over max_board, more than
+ * max_step actions, or more than max_planned plan_action moves in one
+ * Step) closes the connection. At most max_clients bots are served at
+ * once; more connections wait in the listen queue until one finishes.
+*/
+
+#ifndef BOTSERVER_H
+#define BOTSERVER_H
+
+#include <cstdint>
+
+namespace botproto {
+
+enum Opcode : uint8_t { Reset = 1, Step = 2, Close = 3 };
+
+//flags in Tick::flags
+enum TickFlags : uint8_t { Done = 1, Picked = 2, Deposited = 4, Blocked = 8 };
+
+struct ResetRequest
+{
+    uint16_t board_size;
+    uint16_t opp_time;
+    uint8_t moving_enemies;
+    uint8_t obstacles;
+    uint16_t reserved;
+    uint32_t seed;
+};
+
+//what the bot sees after one tick, cloud is the first enemy or -1,-1 on
+//levels without one
+struct Tick
+{
+    int16_t bee_x, bee_y;
+    int16_t flower_x, flower_y;
+    int16_t cloud_x, cloud_y;
+    uint8_t progress;
+    int8_t reward; //1 when pollen dropped at hive, -1 when the game ends
+    uint8_t flags;
+    uint8_t reserved;
+};
+
+struct BoardHeader
+{
+    uint32_t score;
+    uint32_t num_opps;
+    uint32_t num_obstacles;
+    uint32_t num_enemies;
+};
+
+struct CellPos
+{
+    int16_t x, y;
+};
+
+static_assert(sizeof(ResetRequest) == 12, "protocol struct size changed");
+static_assert(sizeof(Tick) == 16, "protocol struct size changed");
+static_assert(sizeof(BoardHeader) == 16, "protocol struct size changed");
+
+//largest board accepted in a Reset
+const uint16_t max_board = 512;
+
+//largest number of actions accepted in one Step
+const uint32_t max_step = 1 << 20;
+
+//action asking the server to plan the move, for demo bots; takes about plan_us
+const uint8_t plan_action = 255;
+const int plan_us = 5000;
+
+//most plan_action moves in one Step, so one Step takes at most about a second
+const uint32_t max_planned = 200;
+
+//most bots served at the same time
+const int max_clients = 16;
+
+}
+
+//listens on socket_path until killed, returns non-zero if it can't listen
+int run_bot_server(const char* socket_path);
+
+#endif // BOTSERVER_H
@@ -0,0 +1,78 @@
+/*
+ * @file counterrng.h
+ * @brief header file to contain the CounterRng struct
+ *
+ * This headerfile contains the CounterRng struct, the random numbers used
+ * to place flowers, opps, obstacles and clouds. Every spawn gets its own
+ * stream of numbers, worked out from the game's seed and which spawn it
+ * is, instead of taking the next numbers from one shared generator. So a
+ * spawn always lands in the same place, whatever else was drawn before it
+ * or on whichever thread it runs.
+*/
+
+#ifndef COUNTERRNG_H
+#define COUNTERRNG_H
+
+#include <cstdint>
+
+/*
+ * @struct CounterRng
+ * @brief stream of random numbers for one (seed, kind, index, tick)
+ *
+ * The stream's key is the four numbers mixed together. Draw n is the key
+ * plus n steps of the golden ratio, mixed again (the SplitMix64 mixer), so
+ * a draw is a few multiplies and shifts and needs no state but a count.
+ */
+struct CounterRng
+{
+    //what a stream is used for, so different kinds never share numbers
+    enum Kind { Session = 0, Flower, Opp, Obstacle, Enemy, EnemyRespawn, Behaviour, Worker, Input };
+
+    uint64_t key;
+    uint64_t count;
+
+    CounterRng(uint64_t seed, Kind kind, uint64_t index, uint64_t tick) : count(0)
+    {
+        key = mix(seed + 0x9E3779B97F4A7C15ull);
+        key = mix(key ^ (uint64_t(kind) << 56));
+        key = mix(key ^ index);
+        key = mix(key ^ tick);
+    }
+
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t next32()
+    {
+        count++;
+        return uint32_t(mix(key + count*0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    /*
+     * Function to draw a number from 0 to n - 1, each equally likely.
+     * The draw is scaled by multiplying instead of dividing; the few draws
+     * that would make some numbers more likely than others are thrown away
+     * and drawn again (Lemire's method).
+     */
+    uint32_t below(uint32_t n)
+    {
+        uint64_t m = uint64_t(next32()) * n;
+        uint32_t low = uint32_t(m);
+        if(low < n)
+        {
+            uint32_t threshold = uint32_t(-n) % n;
+            while(low < threshold)
+            {
+                m = uint64_t(next32()) * n;
+                low = uint32_t(m);
+            }
+        }
+        return uint32_t(m >> 32);
+    }
+};
+
+#endif // COUNTERRNG_H
@@ -0,0 +1,774 @@
+/*
+ * @file enemyscript.cpp
+ * @brief contains class definitions of EnemyScript and EnemyVm classes
+ *
+ * Compiling goes a line at a time. Expressions are read by recursive
+ * descent, each part's result going into the next free register; the
+ * registers an expression used are free again once its line is done.
+ * Names the script sets get a register of their own the first time they
+ * are set.
+ */
+
+#include "enemyscript.h"
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+//registers are one byte
+static const int max_registers = 256;
+
+/*
+ * @class ScriptCompiler
+ * @brief turns one script's source into EnemyScript's instructions
+ */
+class ScriptCompiler
+{
+public:
+    ScriptCompiler(EnemyScript& s) : script(s), line_number(0), pos(0), next_free(EnemyScript::FirstLocal) {}
+
+    bool compile(const std::string& source, std::string& error);
+
+private:
+    //an if waiting for its end
+    struct Block
+    {
+        size_t if_at;
+        size_t else_at; //0 if there is no else yet
+    };
+
+    bool statement();
+    int expression();
+    int and_expression();
+    int not_expression();
+    int comparison();
+    int sum();
+    int term();
+    int unary();
+    int primary();
+
+    int temporary();
+    int emit(int code, int dst, int a, int b);
+    int name_register(const std::string& name) const;
+    void patch(size_t at, size_t target);
+
+    //reading the current line
+    void skip_spaces();
+    bool at_end();
+    bool accept(const char* token);
+    bool word(std::string& out);
+    bool fail(const std::string& message);
+
+    EnemyScript& script;
+    std::vector<std::string> locals; //names the script set, from register FirstLocal on
+    std::vector<Block> blocks;
+
+    std::string line;
+    int line_number;
+    size_t pos;
+    int next_free; //first register not holding a name or a part of the current line
+    std::string problem; //what went wrong, empty if nothing has
+};
+
+/*
+ * Constructor for the EnemyScript class. The script does nothing until it
+ * is compiled.
+ */
+EnemyScript::EnemyScript() :
+    num_registers(FirstLocal), depth(0), randoms(0)
+{
+}
+
+/*
+ * Function to compile a script (see the class comment for the language).
+ * If it can't be compiled the script is left doing nothing.
+ *
+ * @param source is the script
+ * @param error is set to what is wrong, and on which line, on failure
+ * @return true if the script compiled
+ */
+bool EnemyScript::compile(const std::string& source, std::string& error)
+{
+    ops.clear();
+    num_registers = FirstLocal;
+    depth = 0;
+    randoms = 0;
+
+    ScriptCompiler compiler(*this);
+    if(compiler.compile(source, error))
+        return true;
+
+    ops.clear();
+    num_registers = FirstLocal;
+    depth = 0;
+    randoms = 0;
+    return false;
+}
+
+bool ScriptCompiler::compile(const std::string& source, std::string& error)
+{
+    std::istringstream in(source);
+    while(std::getline(in, line))
+    {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        pos = 0;
+
+        if(!statement())
+        {
+            std::ostringstream message;
+            message << "line " << line_number << ": " << problem;
+            error = message.str();
+            return false;
+        }
+
+        //parts of this line are not needed any more
+        next_free = EnemyScript::FirstLocal + locals.size();
+    }
+
+    if(!blocks.empty())
+    {
+        std::ostringstream message;
+        message << "line " << line_number << ": if without end";
+        error = message.str();
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Function to compile the current line.
+ *
+ * @return false if it is wrong, with problem saying why
+ */
+bool ScriptCompiler::statement()
+{
+    std::string first;
+    if(!word(first))
+    {
+        if(at_end())
+            return true;
+        return fail("expected a statement");
+    }
+
+    if(first == "if")
+    {
+        int condition = expression();
+        if(condition < 0)
+            return false;
+
+        Block b = { script.ops.size(), 0 };
+        emit(EnemyScript::If, condition, 0, 0);
+        blocks.push_back(b);
+        script.depth = std::max(script.depth, int(blocks.size()));
+    }
+    else if(first == "else")
+    {
+        if(blocks.empty() || blocks.back().else_at)
+            return fail("else without if");
+
+        blocks.back().else_at = script.ops.size();
+        patch(blocks.back().if_at, script.ops.size());
+        emit(EnemyScript::Else, 0, 0, 0);
+    }
+    else if(first == "end")
+    {
+        if(blocks.empty())
+            return fail("end without if");
+
+        Block b = blocks.back();
+        blocks.pop_back();
+        patch(b.else_at ? b.else_at : b.if_at, script.ops.size());
+        emit(EnemyScript::End, 0, 0, 0);
+    }
+    else if(first == "spawn")
+    {
+        emit(EnemyScript::Spawn, 0, 0, 0);
+    }
+    else
+    {
+        if(!accept("="))
+            return fail("expected = after " + first);
+
+        int target = name_register(first);
+        if(target >= 0 && target < EnemyScript::VX)
+            return fail(first + " can't be set");
+        if(target > EnemyScript::Mem && target < EnemyScript::FirstLocal)
+            return fail(first + " can't be set");
+        if(target < 0)
+        {
+            //a new name; it is 0 until set, even on this line
+            if(first == "if" || first == "else" || first == "end" || first == "spawn" || first == "and"
+                    || first == "or" || first == "not")
+                return fail(first + " can't be a name");
+            target = EnemyScript::FirstLocal + locals.size();
+            if(target >= max_registers)
+                return fail("too many names");
+            locals.push_back(first);
+            next_free = target + 1;
+        }
+
+        int value = expression();
+        if(value < 0)
+            return false;
+        emit(EnemyScript::Set, target, value, 0);
+    }
+
+    if(!at_end())
+        return fail("unexpected text at end of line");
+    return true;
+}
+
+/*
+ * Functions to compile each level of an expression, loosest first. Each
+ * returns the register holding the result, or -1 if the expression is
+ * wrong.
+ */
+int ScriptCompiler::expression()
+{
+    int a = and_expression();
+    while(a >= 0 && accept("or"))
+    {
+        int b = and_expression();
+        if(b < 0)
+            return -1;
+        a = emit(EnemyScript::Or, -1, a, b);
+    }
+    return a;
+}
+
+int ScriptCompiler::and_expression()
+{
+    int a = not_expression();
+    while(a >= 0 && accept("and"))
+    {
+        int b = not_expression();
+        if(b < 0)
+            return -1;
+        a = emit(EnemyScript::And, -1, a, b);
+    }
+    return a;
+}
+
+int ScriptCompiler::not_expression()
+{
+    if(accept("not"))
+    {
+        int a = not_expression();
+        return a < 0 ? -1 : emit(EnemyScript::Not, -1, a, 0);
+    }
+    return comparison();
+}
+
+int ScriptCompiler::comparison()
+{
+    int a = sum();
+    if(a < 0)
+        return -1;
+
+    //> and >= are < and <= the other way round
+    static const struct { const char* token; int code; bool swap; } compares[] = {
+        { "==", EnemyScript::Eq, false }, { "!=", EnemyScript::Ne, false },
+        { "<=", EnemyScript::Le, false }, { ">=", EnemyScript::Le, true },
+        { "<", EnemyScript::Lt, false }, { ">", EnemyScript::Lt, true }
+    };
+    for(size_t i = 0; i < sizeof(compares) / sizeof(compares[0]); i++)
+    {
+        if(accept(compares[i].token))
+        {
+            int b = sum();
+            if(b < 0)
+                return -1;
+            return compares[i].swap ? emit(compares[i].code, -1, b, a) : emit(compares[i].code, -1, a, b);
+        }
+    }
+    return a;
+}
+
+int ScriptCompiler::sum()
+{
+    int a = term();
+    while(a >= 0)
+    {
+        int code;
+        if(accept("+"))
+            code = EnemyScript::Add;
+        else if(accept("-"))
+            code = EnemyScript::Sub;
+        else
+            break;
+
+        int b = term();
+        if(b < 0)
+            return -1;
+        a = emit(code, -1, a, b);
+    }
+    return a;
+}
+
+int ScriptCompiler::term()
+{
+    int a = unary();
+    while(a >= 0)
+    {
+        int code;
+        if(accept("*"))
+            code = EnemyScript::Mul;
+        else if(accept("/"))
+            code = EnemyScript::Div;
+        else if(accept("%"))
+            code = EnemyScript::Mod;
+        else
+            break;
+
+        int b = unary();
+        if(b < 0)
+            return -1;
+        a = emit(code, -1, a, b);
+    }
+    return a;
+}
+
+int ScriptCompiler::unary()
+{
+    if(accept("-"))
+    {
+        int a = unary();
+        return a < 0 ? -1 : emit(EnemyScript::Neg, -1, a, 0);
+    }
+    return primary();
+}
+
+int ScriptCompiler::primary()
+{
+    skip_spaces();
+
+    //number
+    if(pos < line.size() && std::isdigit(static_cast<unsigned char>(line[pos])))
+    {
+        long value = 0;
+        while(pos < line.size() && std::isdigit(static_cast<unsigned char>(line[pos])))
+        {
+            value = value*10 + (line[pos++] - '0');
+            if(value > 32767)
+            {
+                fail("numbers can't be over 32767");
+                return -1;
+            }
+        }
+        return emit(EnemyScript::Const, -1, value & 0xff, (value >> 8) & 0xff);
+    }
+
+    if(accept("("))
+    {
+        int a = expression();
+        if(a < 0)
+            return -1;
+        if(!accept(")"))
+        {
+            fail("expected )");
+            return -1;
+        }
+        return a;
+    }
+
+    std::string name;
+    if(!word(name))
+    {
+        fail("expected a number, name or (");
+        return -1;
+    }
+
+    if(!accept("("))
+    {
+        int reg = name_register(name);
+        if(reg < 0)
+            fail("unknown name " + name);
+        return reg;
+    }
+
+    //function call
+    static const struct { const char* name; int code; int args; } functions[] = {
+        { "abs", EnemyScript::Abs, 1 }, { "sign", EnemyScript::Sign, 1 },
+        { "min", EnemyScript::Min, 2 }, { "max", EnemyScript::Max, 2 },
+        { "random", EnemyScript::Random, 1 }
+    };
+    for(size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++)
+    {
+        if(name != functions[i].name)
+            continue;
+
+        int a = expression();
+        int b = 0;
+        if(a >= 0 && functions[i].args == 2)
+        {
+            if(!accept(","))
+            {
+                fail("expected , in " + name);
+                return -1;
+            }
+            b = expression();
+        }
+        if(a < 0 || b < 0)
+            return -1;
+        if(!accept(")"))
+        {
+            fail("expected ) after " + name);
+            return -1;
+        }
+
+        if(functions[i].code == EnemyScript::Random)
+        {
+            //each call uses a different part of the enemy's stream
+            if(script.randoms >= 256)
+            {
+                fail("too many random calls");
+                return -1;
+            }
+            b = script.randoms++;
+        }
+        return emit(functions[i].code, -1, a, b);
+    }
+
+    fail("unknown function " + name);
+    return -1;
+}
+
+/*
+ * Function to add an instruction.
+ *
+ * @param dst is the register to write, or -1 to use a free one; registers
+ * from a and b on are free again first, as their values aren't needed
+ * after this
+ * @return the register written, or -1 if there are no free ones
+ */
+int ScriptCompiler::emit(int code, int dst, int a, int b)
+{
+    if(dst < 0)
+    {
+        //a and b are the newest parts still needed, so everything from the
+        //lower of them up is free
+        int first_part = EnemyScript::FirstLocal + locals.size();
+        if(code != EnemyScript::Const && a >= first_part)
+            next_free = std::min(next_free, a);
+        if(code >= EnemyScript::Add && code <= EnemyScript::Max && b >= first_part)
+            next_free = std::min(next_free, b);
+        dst = temporary();
+        if(dst < 0)
+            return -1;
+    }
+
+    EnemyScript::Op op = { uint8_t(code), uint8_t(dst), uint8_t(a), uint8_t(b) };
+    script.ops.push_back(op);
+    return dst;
+}
+
+/*
+ * Function to get a free register for part of an expression.
+ */
+int ScriptCompiler::temporary()
+{
+    if(next_free >= max_registers)
+    {
+        fail("line is too complicated");
+        return -1;
+    }
+    script.num_registers = std::max(script.num_registers, next_free + 1);
+    return next_free++;
+}
+
+/*
+ * Function to find the register of a name, -1 if there isn't one.
+ */
+int ScriptCompiler::name_register(const std::string& name) const
+{
+    static const char* const builtins[] = { "x", "y", "vx", "vy", "mem", "bee_x", "bee_y", "tick", "size", "id" };
+    for(int i = 0; i < EnemyScript::FirstLocal; i++)
+    {
+        if(name == builtins[i])
+            return i;
+    }
+
+    for(size_t i = 0; i < locals.size(); i++)
+    {
+        if(name == locals[i])
+            return EnemyScript::FirstLocal + i;
+    }
+    return -1;
+}
+
+/*
+ * Function to set where an if or else jumps to.
+ */
+void ScriptCompiler::patch(size_t at, size_t target)
+{
+    script.ops[at].a = target & 0xff;
+    script.ops[at].b = (target >> 8) & 0xff;
+}
+
+void ScriptCompiler::skip_spaces()
+{
+    while(pos < line.size() && std::isspace(static_cast<unsigned char>(line[pos])))
+        pos++;
+}
+
+bool ScriptCompiler::at_end()
+{
+    skip_spaces();
+    return pos == line.size();
+}
+
+/*
+ * Function to read a token if it is next. Words only match whole words,
+ * so "or" doesn't match the start of "order".
+ */
+bool ScriptCompiler::accept(const char* token)
+{
+    skip_spaces();
+    std::string t(token);
+    if(line.compare(pos, t.size(), t) != 0)
+        return false;
+
+    size_t after = pos + t.size();
+    if(std::isalpha(static_cast<unsigned char>(t[0])) && after < line.size()
+            && (std::isalnum(static_cast<unsigned char>(line[after])) || line[after] == '_'))
+        return false;
+
+    //"<" is not the start of "<=", and "=" is not the start of "=="
+    if((t == "<" || t == ">" || t == "=") && after < line.size() && line[after] == '=')
+        return false;
+
+    pos = after;
+    return true;
+}
+
+/*
+ * Function to read a name or keyword if one is next.
+ */
+bool ScriptCompiler::word(std::string& out)
+{
+    skip_spaces();
+    if(pos == line.size() || !(std::isalpha(static_cast<unsigned char>(line[pos])) || line[pos] == '_'))
+        return false;
+
+    size_t start = pos;
+    while(pos < line.size() && (std::isalnum(static_cast<unsigned char>(line[pos])) || line[pos] == '_'))
+        pos++;
+    out = line.substr(start, pos - start);
+    return true;
+}
+
+bool ScriptCompiler::fail(const std::string& message)
+{
+    if(problem.empty())
+        problem = message;
+    return false;
+}
+
+/*
+ * Constructor for the EnemyVm class.
+ */
+EnemyVm::EnemyVm() : count(0)
+{
+}
+
+/*
+ * Function to make room for a script's registers for n enemies. Memory is
+ * kept from one call to the next, so after the first tick this doesn't
+ * allocate.
+ *
+ * @param script is the script that will be run
+ * @param n is the number of enemies
+ */
+void EnemyVm::load(const EnemyScript& script, size_t n)
+{
+    count = n;
+    regs.resize(script.registers()*n);
+    masks.resize((script.max_depth() + 1)*n);
+}
+
+/*
+ * Function to give a register the same value for every enemy.
+ */
+void EnemyVm::set_all(int reg, int32_t value)
+{
+    std::fill(lane(reg), lane(reg) + count, value);
+}
+
+//arithmetic that wraps round instead of overflowing
+static inline int32_t wrap_add(int32_t a, int32_t b) { return int32_t(uint32_t(a) + uint32_t(b)); }
+static inline int32_t wrap_sub(int32_t a, int32_t b) { return int32_t(uint32_t(a) - uint32_t(b)); }
+static inline int32_t wrap_mul(int32_t a, int32_t b) { return int32_t(uint32_t(a) * uint32_t(b)); }
+
+static inline int32_t safe_div(int32_t a, int32_t b)
+{
+    if(b == 0)
+        return 0;
+    if(b == -1)
+        return wrap_sub(0, a);
+    return a / b;
+}
+
+static inline int32_t safe_mod(int32_t a, int32_t b)
+{
+    if(b == 0 || b == -1)
+        return 0;
+    return a % b;
+}
+
+/*
+ * Function to run a loaded script. Registers X to Id must already be
+ * filled in; vx, vy and mem are left holding their new values.
+ *
+ * @param script is the script passed to load()
+ * @param seed is the game's seed
+ * @param tick is the engine's tick, so random() differs each tick
+ */
+void EnemyVm::run(const EnemyScript& script, uint64_t seed, uint64_t tick)
+{
+    TRACE_SCOPE("EnemyVm::run");
+
+    spawned.clear();
+    size_t n = count;
+    if(n == 0)
+        return;
+
+    //names the script makes start at 0 every tick
+    std::fill(regs.begin() + EnemyScript::FirstLocal*n, regs.end(), 0);
+
+    //the top level applies to every enemy
+    int32_t* mask = &masks[0];
+    std::fill(mask, mask + n, -1);
+
+    //each enemy's random stream, keyed by its id
+    streams.clear();
+    if(script.uses_random())
+    {
+        const int32_t* id = lane(EnemyScript::Id);
+        for(size_t i = 0; i < n; i++)
+            streams.push_back(CounterRng(seed, CounterRng::Behaviour, uint32_t(id[i]), tick));
+    }
+
+    const std::vector<EnemyScript::Op>& ops = script.code();
+    for(size_t pc = 0, end = ops.size(); pc < end; pc++)
+    {
+        const EnemyScript::Op& op = ops[pc];
+        int32_t* d = op.code <= EnemyScript::If ? lane(op.dst) : 0;
+        const int32_t* a = op.code >= EnemyScript::Add && op.code <= EnemyScript::Set ? lane(op.a) : 0;
+        const int32_t* b = op.code >= EnemyScript::Add && op.code <= EnemyScript::Max ? lane(op.b) : 0;
+        size_t target = op.a | (op.b << 8);
+
+        switch (op.code) {
+        case EnemyScript::Const:
+            std::fill(d, d + n, int32_t(int16_t(target)));
+            break;
+        case EnemyScript::Add:
+            for(size_t i = 0; i < n; i++) d[i] = wrap_add(a[i], b[i]);
+            break;
+        case EnemyScript::Sub:
+            for(size_t i = 0; i < n; i++) d[i] = wrap_sub(a[i], b[i]);
+            break;
+        case EnemyScript::Mul:
+            for(size_t i = 0; i < n; i++) d[i] = wrap_mul(a[i], b[i]);
+            break;
+        case EnemyScript::Div:
+            for(size_t i = 0; i < n; i++) d[i] = safe_div(a[i], b[i]);
+            break;
+        case EnemyScript::Mod:
+            for(size_t i = 0; i < n; i++) d[i] = safe_mod(a[i], b[i]);
+            break;
+        case EnemyScript::Eq:
+            for(size_t i = 0; i < n; i++) d[i] = a[i] == b[i];
+            break;
+        case EnemyScript::Ne:
+            for(size_t i = 0; i < n; i++) d[i] = a[i] != b[i];
+            break;
+        case EnemyScript::Lt:
+            for(size_t i = 0; i < n; i++) d[i] = a[i] < b[i];
+            break;
+        case EnemyScript::Le:
+            for(size_t i = 0; i < n; i++) d[i] = a[i] <= b[i];
+            break;
+        case EnemyScript::And:
+            for(size_t i = 0; i < n; i++) d[i] = (a[i] != 0) & (b[i] != 0);
+            break;
+        case EnemyScript::Or:
+            for(size_t i = 0; i < n; i++) d[i] = (a[i] != 0) | (b[i] != 0);
+            break;
+        case EnemyScript::Min:
+            for(size_t i = 0; i < n; i++) d[i] = std::min(a[i], b[i]);
+            break;
+        case EnemyScript::Max:
+            for(size_t i = 0; i < n; i++) d[i] = std::max(a[i], b[i]);
+            break;
+        case EnemyScript::Neg:
+            for(size_t i = 0; i < n; i++) d[i] = wrap_sub(0, a[i]);
+            break;
+        case EnemyScript::Not:
+            for(size_t i = 0; i < n; i++) d[i] = a[i] == 0;
+            break;
+        case EnemyScript::Abs:
+            for(size_t i = 0; i < n; i++) d[i] = a[i] < 0 ? wrap_sub(0, a[i]) : a[i];
+            break;
+        case EnemyScript::Sign:
+            for(size_t i = 0; i < n; i++) d[i] = (a[i] > 0) - (a[i] < 0);
+            break;
+        case EnemyScript::Random:
+            //draw k of a stream starts at k << 32, so one call never uses another's numbers
+            for(size_t i = 0; i < n; i++)
+            {
+                if(a[i] <= 0)
+                {
+                    d[i] = 0;
+                    continue;
+                }
+                CounterRng rng = streams[i];
+                rng.count = uint64_t(op.b) << 32;
+                d[i] = rng.below(a[i]);
+            }
+            break;
+        case EnemyScript::Set:
+            for(size_t i = 0; i < n; i++) d[i] = (a[i] & mask[i]) | (d[i] & ~mask[i]);
+            break;
+        case EnemyScript::If:
+        {
+            const int32_t* c = d;
+            int32_t* inner = mask + n;
+            int32_t any = 0;
+            for(size_t i = 0; i < n; i++)
+            {
+                inner[i] = mask[i] & -int32_t(c[i] != 0);
+                any |= inner[i];
+            }
+            mask = inner;
+            if(!any)
+                pc = target - 1;
+            break;
+        }
+        case EnemyScript::Else:
+        {
+            //the enemies the if applied to were in the level above and had the condition
+            const int32_t* outer = mask - n;
+            int32_t any = 0;
+            for(size_t i = 0; i < n; i++)
+            {
+                mask[i] = outer[i] & ~mask[i];
+                any |= mask[i];
+            }
+            if(!any)
+                pc = target - 1;
+            break;
+        }
+        case EnemyScript::End:
+            mask -= n;
+            break;
+        case EnemyScript::Spawn:
+            for(size_t i = 0; i < n; i++)
+            {
+                if(mask[i])
+                    spawned.push_back(i);
+            }
+            break;
+        }
+    }
+}
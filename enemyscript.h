@@ -0,0 +1,147 @@
+/*
+ * @file enemyscript.h
+ * @brief header file to contain EnemyScript and EnemyVm class declarations
+ *
+ * This headerfile contains the class declarations of the EnemyScript class,
+ * an enemy behaviour written in a small language and compiled to bytecode,
+ * and the EnemyVm class, which runs a script for every enemy that has it.
+ * GameEngine runs each behaviour once per tick, before the enemies move,
+ * so scripts steer enemies and the engine's rules still move them.
+*/
+
+#ifndef ENEMYSCRIPT_H
+#define ENEMYSCRIPT_H
+
+#include "counterrng.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * @class EnemyScript
+ * @brief one enemy behaviour, compiled
+ *
+ * A script is one statement per line, and # starts a comment:
+ *
+ *     name = expression
+ *     if expression
+ *     else
+ *     end
+ *     spawn
+ *
+ * Names are whole numbers kept per enemy. These are always there:
+ *  - x, y: where the enemy is
+ *  - vx, vy: how it moves this tick; it moves max(|vx|, |vy|) squares
+ *    towards the signs of vx and vy, so (1,0) is right and (-2,2) is two
+ *    squares down and left. Kept from tick to tick.
+ *  - mem: a number kept from tick to tick for the script's own use
+ *  - bee_x, bee_y, tick, size (of the board) and id (of the enemy)
+ * Only vx, vy, mem and names the script makes itself can be set; names the
+ * script makes start at 0 every tick.
+ *
+ * Expressions have numbers, names, + - * / %, comparisons (== != < <= >
+ * >=, 1 if true and 0 if not), and, or, not, brackets, and the functions
+ * abs(a), sign(a), min(a, b), max(a, b) and random(n) (0 to n - 1, from the
+ * enemy's own stream for the tick). Dividing by 0 gives 0.
+ *
+ * spawn adds a new enemy with the same behaviour somewhere else on the
+ * board. For example, an enemy that chases the bee when it is close and
+ * goes back and forth otherwise:
+ *
+ *     if abs(bee_x - x) + abs(bee_y - y) <= 4
+ *         vx = sign(bee_x - x)
+ *         vy = sign(bee_y - y)
+ *     else
+ *         mem = mem + 1
+ *         if mem % 6 == 0
+ *             vx = -vx
+ *         end
+ *     end
+ */
+class EnemyScript
+{
+public:
+    enum Opcode
+    {
+        Const = 0, //dst = a | b << 8, as a signed 16 bit number
+        Add, Sub, Mul, Div, Mod, //dst = a op b
+        Eq, Ne, Lt, Le, And, Or,
+        Min, Max,
+        Neg, Not, Abs, Sign, //dst = op a
+        Random, //dst = random(a), b is which draw of the stream to use
+        Set, //dst = a, only for enemies the current if applies to
+        If, //dst is the condition; jump to a | b << 8 if it is false for every enemy
+        Else, //jump to a | b << 8 if every enemy took the if
+        End,
+        Spawn
+    };
+
+    //registers of the names that are always there, then the script's own
+    enum Register { X = 0, Y, VX, VY, Mem, BeeX, BeeY, Tick, Size, Id, FirstLocal };
+
+    //one instruction; a and b are registers unless the opcode says otherwise
+    struct Op
+    {
+        uint8_t code;
+        uint8_t dst;
+        uint8_t a;
+        uint8_t b;
+    };
+
+    EnemyScript();
+
+    //compile source; false with a message saying which line is wrong if it can't be
+    bool compile(const std::string& source, std::string& error);
+
+    const std::vector<Op>& code() const { return ops; }
+    int registers() const { return num_registers; }
+    int max_depth() const { return depth; }
+    bool uses_random() const { return randoms > 0; }
+
+private:
+    friend class ScriptCompiler;
+
+    std::vector<Op> ops;
+    int num_registers;
+    int depth; //most ifs inside each other
+    int randoms; //number of random() calls
+};
+
+/*
+ * @class EnemyVm
+ * @brief runs a script for many enemies at once
+ *
+ * Every register holds one number per enemy, side by side. Each
+ * instruction is decoded once and then applied to all the enemies in a
+ * tight loop, so the cost of working out what to do is paid once per
+ * tick rather than once per enemy, and the loops are simple enough for the
+ * compiler to use vector instructions. An if works out which enemies it
+ * applies to instead of jumping; only setting names looks at that, and an
+ * if that applies to no enemy is skipped.
+ */
+class EnemyVm
+{
+public:
+    EnemyVm();
+
+    //get ready to run script for n enemies; fill in X to Id with lane()
+    void load(const EnemyScript& script, size_t n);
+    int32_t* lane(int reg) { return &regs[reg*count]; }
+    void set_all(int reg, int32_t value);
+
+    //run the loaded script; seed picks the random streams
+    void run(const EnemyScript& script, uint64_t seed, uint64_t tick);
+
+    //enemies (by lane) that ran spawn, once for each time they did
+    const std::vector<uint32_t>& spawns() const { return spawned; }
+
+private:
+    size_t count; //enemies
+    std::vector<int32_t> regs;
+    std::vector<int32_t> masks; //-1 for enemies each if applies to, one row per depth
+    std::vector<uint32_t> spawned;
+    std::vector<CounterRng> streams; //each enemy's random numbers for the tick
+};
+
+#endif // ENEMYSCRIPT_H
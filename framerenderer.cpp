@@ -0,0 +1,378 @@
+/*
+ * @file framerenderer.cpp
+ * @brief contains class definition of FrameRenderer class
+ *
+ * The image is RGB32: the header strip on top (if there is one), then the
+ * board, square (0,0) at the top left. The header has the progress bar and
+ * message on the left and the score on the right, like GameBoard's Hud.
+ *
+ * run_frame_export() is what hw4b --export-frames runs. Before saving
+ * anything it draws the same board with a BoardView and compares the two,
+ * so the renderer can't quietly drift from what the game shows.
+ */
+
+#include "framerenderer.h"
+#include "boardview.h"
+#include "counterrng.h"
+#include "spriteatlas.h"
+#include <QPainter>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//height of the header strip, and width of its progress bar
+static const int header_height = 30;
+static const int bar_width = 100;
+
+/*
+ * Function to put a piece in a square. Pieces are numbered in the order
+ * they are drawn, so the bigger one wins.
+ */
+static void put(std::vector<uint8_t>& pieces, size_t board_size, const Cell& c, GameEngine::Piece p)
+{
+    uint8_t& square = pieces[c.y*board_size + c.x];
+    if(p > square)
+        square = p;
+}
+
+/*
+ * Constructor for the FrameRenderer class. Makes the tile for each piece.
+ *
+ * @param board_sz is number of squares along each side of the board
+ * @param sd is pixels per square, 0 for 500 / board_sz
+ * @param hud is whether to draw the header above the board
+ */
+FrameRenderer::FrameRenderer(size_t board_sz, int sd, bool hud) :
+    board_size(board_sz), side(sd > 0 ? sd : 500 / board_sz), hud_height(hud ? header_height : 0),
+    pieces(board_sz*board_sz, GameEngine::Empty), drawn(board_sz*board_sz, 0xff),
+    theme(Theme::standard()), hud_progress(-1), hud_score(0), hud_message(-1)
+{
+    //same pictures GameBoard uses for each piece
+    static const char* const names[GameEngine::Flower + 1] =
+        { 0, "child", "bee", "hive", "cloud", "factory", "flower" };
+
+    for(int p = 0; p <= GameEngine::Flower; p++)
+    {
+        tiles[p] = QImage(side, side, QImage::Format_RGB32);
+        tiles[p].fill(theme.squares.color(QPalette::Window));
+        if(!names[p])
+            continue;
+
+        QPainter painter(&tiles[p]);
+        painter.drawImage(0, 0, SpriteAtlas::image(names[p], side));
+    }
+
+    int edge = side*board_size;
+    frame = QImage(edge, edge + hud_height, QImage::Format_RGB32);
+    frame.fill(theme.hud.color(QPalette::Window));
+
+    progress_text.setPerformanceHint(QStaticText::AggressiveCaching);
+    score_text.setPerformanceHint(QStaticText::AggressiveCaching);
+    message_text.setPerformanceHint(QStaticText::AggressiveCaching);
+}
+
+/*
+ * Function to copy the tile of every square whose piece changed since the
+ * last render into the frame.
+ */
+void FrameRenderer::draw_squares()
+{
+    size_t row_bytes = side*sizeof(quint32);
+
+    for(size_t pos = 0, n = pieces.size(); pos < n; pos++)
+    {
+        if(pieces[pos] == drawn[pos])
+            continue;
+        drawn[pos] = pieces[pos];
+
+        const QImage& tile = tiles[pieces[pos]];
+        int x = (pos % board_size)*side;
+        int y = (pos / board_size)*side + hud_height;
+        for(int row = 0; row < side; row++)
+        {
+            uchar* out = frame.scanLine(y + row) + x*sizeof(quint32);
+            std::memcpy(out, tile.constScanLine(row), row_bytes);
+        }
+    }
+}
+
+/*
+ * Function to draw the header, only if something in it changed.
+ *
+ * @param progress is how full the progress bar is, 0-100
+ * @param score is the score
+ * @param message is which message to show next to the bar
+ */
+void FrameRenderer::draw_hud(int progress, size_t score, Message message)
+{
+    if(hud_height == 0)
+        return;
+    if(progress == hud_progress && score == hud_score && int(message) == hud_message)
+        return;
+
+    //text is only laid out again when it changes
+    if(progress != hud_progress)
+    {
+        progress_text.setText(QString::number(progress) + "%");
+        progress_text.prepare(QTransform(), QFont());
+    }
+    if(score != hud_score || hud_progress < 0)
+    {
+        score_text.setText(QString::number(score));
+        score_text.prepare(QTransform(), theme.score_font);
+    }
+    if(int(message) != hud_message)
+    {
+        if(message == HiveReady)
+            message_text.setText("Time to visit the hive!");
+        else if(message == HeldOver)
+            message_text.setText("Game over");
+        else
+            message_text.setText(QString());
+        message_text.prepare(QTransform(), theme.message_font);
+    }
+
+    hud_progress = progress;
+    hud_score = score;
+    hud_message = message;
+
+    QPainter painter(&frame);
+    QRect strip(0, 0, frame.width(), hud_height);
+    painter.fillRect(strip, theme.hud.color(QPalette::Window));
+
+    QRect bar(2, 4, bar_width, hud_height - 8);
+    painter.setPen(theme.bar_border);
+    painter.setBrush(theme.bar_background);
+    painter.drawRect(bar.adjusted(0, 0, -1, -1));
+    painter.fillRect(QRect(bar.left() + 1, bar.top() + 1, (bar.width() - 1)*progress / 100, bar.height() - 1),
+                     theme.bar_color);
+
+    QSizeF size = progress_text.size();
+    painter.setPen(theme.hud.color(QPalette::WindowText));
+    painter.setFont(QFont());
+    painter.drawStaticText(QPointF(bar.center().x() - size.width() / 2, bar.center().y() - size.height() / 2),
+                           progress_text);
+
+    size = message_text.size();
+    painter.setPen(theme.message_color);
+    painter.setFont(theme.message_font);
+    painter.drawStaticText(QPointF(bar.right() + 8, (hud_height - size.height()) / 2), message_text);
+
+    size = score_text.size();
+    painter.setPen(theme.hud.color(QPalette::WindowText));
+    painter.setFont(theme.score_font);
+    painter.drawStaticText(QPointF(frame.width() - 4 - size.width(), (hud_height - size.height()) / 2), score_text);
+}
+
+/*
+ * Function to draw a game from its engine. Each square gets the piece
+ * piece_at() would give it, worked out from the engine's lists.
+ *
+ * @param engine is the game to draw
+ * @return the frame, valid until the next render
+ */
+const QImage& FrameRenderer::render(const GameEngine& engine)
+{
+    std::fill(pieces.begin(), pieces.end(), uint8_t(GameEngine::Empty));
+
+    for(size_t i = 0, n = engine.clouds().size(); i < n; i++)
+        put(pieces, board_size, engine.clouds()[i], GameEngine::Cloud);
+    put(pieces, board_size, engine.bee(), GameEngine::Bee);
+    put(pieces, board_size, engine.hive(), GameEngine::Hive);
+    for(size_t i = 0, n = engine.opps().size(); i < n; i++)
+        put(pieces, board_size, engine.opps()[i], GameEngine::Opp);
+    for(size_t i = 0, n = engine.obstacle_cells().size(); i < n; i++)
+        put(pieces, board_size, engine.obstacle_cells()[i], GameEngine::Obstacle);
+    put(pieces, board_size, engine.flower(), GameEngine::Flower);
+
+    draw_squares();
+    draw_hud(engine.get_progress(), engine.get_score(), engine.hive_ready() ? HiveReady : NoMessage);
+    return frame;
+}
+
+/*
+ * Function to draw a frame published by a Simulation.
+ *
+ * @param f is the frame to draw
+ * @return the frame, valid until the next render
+ */
+const QImage& FrameRenderer::render(const Simulation::Frame& f)
+{
+    pieces = f.pieces;
+    draw_squares();
+
+    Message message = NoMessage;
+    if(f.over && f.rewinding)
+        message = HeldOver;
+    else if(f.hive_ready)
+        message = HiveReady;
+    draw_hud(f.progress, f.score, message);
+    return frame;
+}
+
+/*
+ * Function to draw part of a recorded game as one image, frames in rows.
+ *
+ * @param history is the recorded game
+ * @param engine is changed to each tick in turn; it must have the same
+ * board size as the renderer
+ * @param first is the first tick to draw
+ * @param last is the last tick to draw
+ * @param columns is how many frames go across
+ * @return the image, or a null image if the ticks aren't all kept
+ */
+QImage FrameRenderer::strip(RewindBuffer& history, GameEngine& engine, uint64_t first, uint64_t last, int columns)
+{
+    if(history.empty() || first > last || first < history.first_tick() || last > history.last_tick() || columns < 1)
+        return QImage();
+
+    uint64_t count = last - first + 1;
+    int rows = int((count + columns - 1) / columns);
+    QSize size = frame.size();
+
+    QImage out(size.width()*qMin<uint64_t>(columns, count), size.height()*rows, QImage::Format_RGB32);
+    out.fill(Qt::white);
+
+    size_t row_bytes = size.width()*sizeof(quint32);
+    for(uint64_t i = 0; i < count; i++)
+    {
+        history.restore(first + i, engine);
+        const QImage& f = render(engine);
+
+        int x = int(i % columns)*size.width();
+        int y = int(i / columns)*size.height();
+        for(int row = 0; row < size.height(); row++)
+            std::memcpy(out.scanLine(y + row) + x*sizeof(quint32), f.constScanLine(row), row_bytes);
+    }
+    return out;
+}
+
+/*
+ * Function to compare the renderer's board with a BoardView's. BoardView
+ * leaves the bee and clouds to the SpriteLayer, so those squares aren't
+ * compared; every other pixel may differ by rounding only.
+ *
+ * @param engine is the game to draw
+ * @return number of squares that differ
+ */
+static int compare_with_board_view(const GameEngine& engine)
+{
+    //same pictures as GameBoard gives its BoardView
+    static const char* const names[GameEngine::Flower + 1] =
+        { 0, 0, 0, "hive", "cloud", "factory", "flower" };
+    const int max_difference = 2;
+
+    size_t board_size = engine.get_board_size();
+    FrameRenderer renderer(board_size, 0, false);
+    const QImage& ours = renderer.render(engine);
+    int side = ours.width() / int(board_size);
+
+    std::vector<uint8_t> pieces(board_size*board_size);
+    for(size_t i = 0; i < pieces.size(); i++)
+        pieces[i] = engine.piece_at(i % board_size, i / board_size);
+
+    BoardView view(board_size, Theme::standard());
+    for(int p = GameEngine::Hive; p <= GameEngine::Flower; p++)
+        view.set_picture(p, SpriteAtlas::pixmap(names[p], side));
+    view.set_pieces(pieces);
+
+    //the view has to put the squares where the renderer does: its usual
+    //500px minimum would leave a 495px board centred with fractional squares
+    view.setMinimumSize(0, 0);
+    view.resize(ours.size());
+    view.fit();
+    if(view.view_origin() != QPointF(0, 0) || view.square_side() != side)
+    {
+        std::fprintf(stderr, "export: BoardView put squares of %g at %g,%g, the renderer squares of %d at 0,0\n",
+                     view.square_side(), view.view_origin().x(), view.view_origin().y(), side);
+        return int(pieces.size());
+    }
+
+    QImage theirs = view.grab().toImage().convertToFormat(QImage::Format_RGB32);
+    if(theirs.size() != ours.size())
+    {
+        std::fprintf(stderr, "export: BoardView drew %dx%d, the renderer %dx%d\n",
+                     theirs.width(), theirs.height(), ours.width(), ours.height());
+        return int(pieces.size());
+    }
+
+    int differ = 0;
+    for(size_t i = 0; i < pieces.size(); i++)
+    {
+        if(pieces[i] == GameEngine::Bee || pieces[i] == GameEngine::Cloud)
+            continue;
+
+        int x0 = int(i % board_size)*side, y0 = int(i / board_size)*side;
+        bool same = true;
+        for(int y = y0; y < y0 + side && same; y++)
+        {
+            const QRgb* a = reinterpret_cast<const QRgb*>(ours.constScanLine(y));
+            const QRgb* b = reinterpret_cast<const QRgb*>(theirs.constScanLine(y));
+            for(int x = x0; x < x0 + side && same; x++)
+            {
+                same = std::abs(qRed(a[x]) - qRed(b[x])) <= max_difference
+                        && std::abs(qGreen(a[x]) - qGreen(b[x])) <= max_difference
+                        && std::abs(qBlue(a[x]) - qBlue(b[x])) <= max_difference;
+            }
+        }
+        if(!same)
+        {
+            if(differ < 10)
+                std::fprintf(stderr, "export: square %d,%d (piece %d) differs from BoardView\n",
+                             int(i % board_size), int(i / board_size), int(pieces[i]));
+            differ++;
+        }
+    }
+    return differ;
+}
+
+/*
+ * Function to play and export a game. The game is hard on a 15x15 board
+ * with the bee's moves drawn from a fixed seed, so the image only changes
+ * when the game or the drawing does.
+ *
+ * @param image_path is where to save the image; the format comes from the
+ * file name, such as .png
+ * @param ticks is the most ticks to play; the game may end sooner
+ * @return 0 if the image was saved, 1 if not
+ */
+int run_frame_export(const char* image_path, int ticks)
+{
+    const size_t board_size = 15;
+    const unsigned seed = 1;
+    const int columns = 10;
+
+    GameEngine engine(board_size, 5, true, true, seed);
+    engine.clear_changed();
+    RewindBuffer history(RewindBuffer::bytes_for(board_size));
+
+    history.record(engine);
+    for(int t = 0; t < ticks && !engine.is_over(); t++)
+    {
+        CounterRng random(seed, CounterRng::Input, 0, t);
+        engine.press(static_cast<GameEngine::Move>(random.below(5)));
+        engine.move_enemy();
+        engine.clear_changed();
+        history.record(engine);
+    }
+
+    int differ = compare_with_board_view(engine);
+    if(differ > 0)
+    {
+        std::fprintf(stderr, "export: %d squares differ from BoardView, nothing saved\n", differ);
+        return 1;
+    }
+
+    FrameRenderer renderer(board_size);
+    QImage out = renderer.strip(history, engine, history.first_tick(), history.last_tick(), columns);
+    if(out.isNull() || !out.save(QString::fromLocal8Bit(image_path)))
+    {
+        std::fprintf(stderr, "export: can't save %s\n", image_path);
+        return 1;
+    }
+
+    std::fprintf(stderr, "export: %llu ticks saved to %s, the last matches BoardView\n",
+                 (unsigned long long)(history.last_tick() - history.first_tick() + 1), image_path);
+    return 0;
+}
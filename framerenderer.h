@@ -0,0 +1,86 @@
+/*
+ * @file framerenderer.h
+ * @brief header file to contain FrameRenderer class declarations
+ *
+ * This headerfile contains the class declaration of the FrameRenderer class,
+ * which draws a game into a QImage without any widgets or window. It is for
+ * thumbnails, comparing screenshots in tests, and turning recorded games
+ * into frames for a video encoder.
+*/
+
+#ifndef FRAMERENDERER_H
+#define FRAMERENDERER_H
+
+#include "gameengine.h"
+#include "rewind.h"
+#include "simulation.h"
+#include "theme.h"
+#include <QImage>
+#include <QStaticText>
+#include <cstdint>
+#include <vector>
+
+/*
+ * @class FrameRenderer
+ * @brief draws the board and header the way GameBoard shows them
+ *
+ * Each piece is drawn over a white square once, when the renderer is made,
+ * so drawing a square is just copying rows of pixels. The image is kept
+ * between calls and only squares whose piece changed are copied again;
+ * the header is only drawn again when the progress, score or message
+ * changes. Drawing a run of ticks from one game therefore costs about as
+ * much as the squares that change between them.
+ *
+ * Text needs a QGuiApplication (the offscreen platform is enough), but no
+ * widgets are made. The image returned is reused by the next render(); copy
+ * it to keep it.
+ */
+class FrameRenderer
+{
+public:
+    //side is pixels per square, 0 for the same size as the 500px board
+    explicit FrameRenderer(size_t board_size, int side = 0, bool hud = true);
+
+    //draw the engine's game, or a frame from a Simulation
+    const QImage& render(const GameEngine& engine);
+    const QImage& render(const Simulation::Frame& f);
+
+    //ticks first to last of a recorded game, left to right and top to
+    //bottom, columns frames across; engine is used to restore each tick
+    QImage strip(RewindBuffer& history, GameEngine& engine, uint64_t first, uint64_t last, int columns);
+
+    QSize frame_size() const { return frame.size(); }
+
+private:
+    enum Message { NoMessage = 0, HiveReady, HeldOver };
+
+    void draw_squares();
+    void draw_hud(int progress, size_t score, Message message);
+
+    size_t board_size;
+    int side;
+    int hud_height; //0 without the header
+
+    QImage tiles[GameEngine::Flower + 1]; //each piece on a white square
+    QImage frame;
+
+    std::vector<uint8_t> pieces; //what should be in each square
+    std::vector<uint8_t> drawn; //what frame shows in each square
+
+    //header as last drawn, -1 before it is first drawn
+    const Theme& theme;
+    int hud_progress;
+    size_t hud_score;
+    int hud_message;
+    QStaticText progress_text;
+    QStaticText score_text;
+    QStaticText message_text;
+};
+
+//play a game with seeded random moves, check its last tick draws the same
+//as BoardView, and save every tick as one image at image_path; returns
+//non-zero if the check or the save fails. Needs a QApplication. Used by
+//hw4b --export-frames
+int run_frame_export(const char* image_path, int ticks);
+
+#endif // FRAMERENDERER_H
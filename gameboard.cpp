@@ -5,162 +5,215 @@
  * This file defines the GameBoard class and sets up the
  * board. The bee and hive start in diagonally opposite corners.
  * The opponents appear around the board and can chase the bee.
+ * The rules themselves live in GameEngine, which Simulation runs on
+ * its own thread; GameBoard shows the frames it sends and passes the
+ * arrow keys to it.
  */
 
 #include "gameboard.h"
 #include "ui_gameboard.h"
+#include "spriteatlas.h"
+#include "trace.h"
+#include "theme.h"
+#include "inputstress.h"
 #include <mainwindow.h>
 #include <QPushButton>
 #include <QPainter>
-#include <QCoreApplication>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <vector>
-#include <QProgressBar>
 #include <QHBoxLayout>
 #include <chrono>
-#include <random>
 #include <QTimer>
 #include <QDebug>
 #include <QString>
 
 #include <QFont>
 #include <QMultimedia>
+#include <QFile>
 
 
-unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-std::default_random_engine generator (seed);
+//each game's seed comes from when the program started and how many games came before
+static uint64_t session_seed = std::chrono::system_clock::now().time_since_epoch().count();
+static uint64_t games_played = 0;
 
 /*
- * Constructor for the GameBoard class.
+ * Function to read the enemy script named by HW4B_ENEMY_SCRIPT, for
+ * designers trying out behaviours. A script that can't be read or compiled
+ * is reported and the enemies go straight as usual.
  *
- * @param parent sets GameBoard a parent widget
- * @param board_sz is size of board
-*/
-GameBoard::GameBoard(QWidget *parent, size_t board_sz, int tm, bool moving_enem, bool obst) :
-    QWidget(parent),
-    ui(new Ui::GameBoard), board_size(board_sz), opp_time(tm), moving_enemies(moving_enem), obstacles(obst)
+ * @param script receives the compiled script
+ * @return true if there is a script to use
+ */
+static bool load_enemy_script(EnemyScript& script)
 {
-    ui->setupUi(this);
+    const char* path = std::getenv("HW4B_ENEMY_SCRIPT");
+    if(!path)
+        return false;
 
-    counter = 0;
-    score = 0;
-    num_opps = 0;
-
-    //open bee and hive images, position set later
-    QString fileName(":/image/bee.jpg");
-    bee_image = new QPixmap(fileName);
-    QString hive_fileName(":/image/hive.jpg");
-    hive_image = new QPixmap(hive_fileName);
-
-
-    //create the Board
-    Board = new QWidget;
-    labels = new QLabel*[board_size*board_size]; //square Board
-    QGridLayout *SquareGrid = new QGridLayout (Board);
-
-    //make the grid a rectangle (a square)
-    SquareGrid->setGeometry(QRect());
-    SquareGrid->setSpacing(0);
-
-    //fill SquareGrid with labels in each grid
-    for(size_t i = 0; i < board_size; i++)
+    QFile file(QString::fromLocal8Bit(path));
+    if(!file.open(QIODevice::ReadOnly))
     {
-        for(size_t j = 0; j < board_size; j++)
-        {
-            //create new label, each with new number
-            labels[i*board_size+j] = new QLabel;
-
-            //add label to the layout
-            SquareGrid -> addWidget(labels[i*board_size+j] ,i,j);
-        }
+        qWarning("enemy script: can't read %s", path);
+        return false;
     }
 
-    //initialize bee at top left corner, always starts at same place
-    bee_position = new QPoint(0,0);
-    labels[0]->setPixmap(*bee_image);
-    labels[0]->setScaledContents(true);
-    labels[0]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+    std::string error;
+    if(!script.compile(file.readAll().toStdString(), error))
+    {
+        qWarning("enemy script: %s: %s", path, error.c_str());
+        return false;
+    }
+    return true;
+}
 
-    //initialize hive to top right corner, always starts at same place
-    hive_position = new QPoint(board_size - 1,0);
-    labels[board_size - 1]->setPixmap(*hive_image);
-    labels[board_size - 1]->setScaledContents(true);
-    labels[board_size - 1]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+/*
+ * Function to read how many worker bees swarm mode has from HW4B_SWARM,
+ * which is "workers" or "workers,board size" (such as 5000,512).
+ *
+ * @return number of workers, 0 for no swarm
+ */
+static size_t swarm_size()
+{
+    const char* count = std::getenv("HW4B_SWARM");
+    if(!count)
+        return 0;
+    return std::strtoul(count, 0, 10);
+}
 
-    Board->setFixedSize(500,500);
+/*
+ * Function to read the board size swarm mode plays on from HW4B_SWARM, so
+ * a big swarm can have a big board, up to 4096x4096; tools/panbench
+ * measures how fast a board that big pans.
+ *
+ * @param asked is the size the menu asked for
+ * @return the size after the comma in HW4B_SWARM, or asked if there is none
+ */
+static size_t swarm_board_size(size_t asked)
+{
+    const size_t biggest = 4096;
 
-    //open flower image
-    QString flower_fileName(":/image/flower.png");
-    flower_image = new QPixmap(flower_fileName);
+    const char* settings = std::getenv("HW4B_SWARM");
+    const char* comma = settings ? std::strchr(settings, ',') : 0;
+    if(!comma)
+        return asked;
 
-    //set flower to random place on grid
-    this->setFlower();
+    size_t size = std::strtoul(comma + 1, 0, 10);
+    if(size < 2 || size > biggest)
+    {
+        qWarning("HW4B_SWARM: board size must be 2 to %u", unsigned(biggest));
+        return asked;
+    }
+    return size;
+}
 
-    //create enemy if correct level
-    if(moving_enemies)
-        this->create_enemy();
+/*
+ * Constructor for the GameBoard class.
+ *
+ * @param parent sets GameBoard a parent widget
+ * @param board_sz is size of board, unless swarm mode gives its own
+*/
+GameBoard::GameBoard(QWidget *parent, size_t board_sz, int tm, bool moving_enem, bool obst) :
+    QWidget(parent),
+    ui(new Ui::GameBoard), board_size(swarm_board_size(board_sz)), opp_time(tm), moving_enemies(moving_enem), obstacles(obst)
+{
+    ui->setupUi(this);
 
-    //open opponent image
-    QString opp_fileName(":/image/cloud.png");
-    opp_image = new QPixmap(opp_fileName);
+    //each game gets its own seed from the session's. The game runs
+    //on its own thread; enemies move every 100ms, and without them nothing
+    //happens between key presses, so the board never wakes up on its own
+    over_sent = false;
+    frame_posted = false;
+    board_frame = 0;
+    EnemyScript enemy_script;
+    bool scripted = load_enemy_script(enemy_script);
+
+    //the game adds to the heatmap of its difficulty as it is played
+    heatmap = new Heatmap(board_size);
+    heat_difficulty = GameEngine::difficulty(moving_enemies, obstacles);
+    heat_shown = -1;
+
+    sim = new Simulation(board_size, opp_time, moving_enemies, obstacles,
+                         CounterRng(session_seed, CounterRng::Session, games_played++, 0).next32(), 100,
+                         [this] { frame_ready(); }, scripted ? &enemy_script : 0, swarm_size(),
+                         heatmap->counts(heat_difficulty));
+    sim->update();
+    const Simulation::Frame& start = sim->frame();
+
+    //testers set HW4B_REWIND to rewind from game over instead of ending the game
+    hold_game_over = std::getenv("HW4B_REWIND") != 0;
+
+    //HW4B_STRESS presses keys on the board far faster than a person can, to
+    //check nothing falls behind; see InputStress. The game is held at game
+    //over so the presses carry on playing it
+    if(std::getenv("HW4B_STRESS"))
+    {
+        hold_game_over = true;
+        new InputStress(this, sim, QString::fromLocal8Bit(std::getenv("HW4B_STRESS")));
+    }
 
-    //if on level that has obstacles, open obstacle image
-    if(obstacles)
+    //get images from the sprite atlas at the biggest size it has, so they
+    //still look sharp when zoomed in; positions come from the engine
+    int side = 50;
+    bee_image = new QPixmap(SpriteAtlas::pixmap("bee", side));
+    hive_image = new QPixmap(SpriteAtlas::pixmap("hive", side));
+    flower_image = new QPixmap(SpriteAtlas::pixmap("flower", side));
+    opp_image = new QPixmap(SpriteAtlas::pixmap("cloud", side));
+    cloud_image = new QPixmap(SpriteAtlas::pixmap("child", side));
+    obstacle_image = new QPixmap(SpriteAtlas::pixmap("factory", side));
+
+
+    //create the Board; it starts with the whole board in 500x500 and can
+    //be zoomed with the wheel and panned by dragging
+    const Theme& theme = Theme::standard();
+    Board = new BoardView(board_size, theme);
+    Board->set_picture(GameEngine::Hive, *hive_image);
+    Board->set_picture(GameEngine::Flower, *flower_image);
+    Board->set_picture(GameEngine::Opp, *opp_image);
+    Board->set_picture(GameEngine::Obstacle, *obstacle_image);
+
+    //bee and cloud slide between squares on a layer over the board; when
+    //squares are too small for pictures the board draws them as colours
+    layer = new SpriteLayer(Board, board_size);
+    connect(Board, SIGNAL(view_changed(QPointF,qreal)), this, SLOT(view_changed(QPointF,qreal)));
+    minimap = new Minimap(Board);
+    bee_sprite = layer->add_sprite(*bee_image);
+    layer->move_sprite(bee_sprite, start.bee.x, start.bee.y, 0);
+    for(size_t i = 0, n = start.clouds.size(); i < n; i++)
     {
-        QString obstacle_fileName(":/image/factory.png");
-        obstacle_image = new QPixmap(obstacle_fileName);
+        cloud_sprites.push_back(layer->add_sprite(*cloud_image));
+        layer->move_sprite(cloud_sprites[i], start.clouds[i].x, start.clouds[i].y, 0);
     }
 
     QVBoxLayout *game_layout = new QVBoxLayout;
 
-    //font is Impact, used for score
-    QFont impact("Impact", 14);
-    QFont headerFont("Impact", 20);
-
     //add header at top of game
     QLabel* header = new QLabel;
     header->setText("Keep the hive alive!");
-    header->setFont(headerFont);
+    header->setFont(theme.header_font);
+    header->setAutoFillBackground(true);
+    header->setPalette(theme.hud);
     header->setAlignment(Qt::AlignCenter);
     game_layout->addWidget((header));
 
-    QHBoxLayout *progress_layout = new QHBoxLayout;
-
-    //progress bar to keep track of how much pollen collected
-    progress = new QProgressBar;
-    progress->setValue(counter); //counter = 0
-    progress->setMaximumWidth(100); //make bar smaller
-    progress_layout->addWidget(progress);
-
-    //displays message when progress bar full
-    fullMessage = new QLabel;
-    progress_layout->addWidget(fullMessage);
+    //progress bar to keep track of how much pollen collected, message when
+    //it is full, and the score
+    scoreImage = new QPixmap(SpriteAtlas::pixmap("score", 0));
+    hud = new Hud(theme, *scoreImage);
+    hud->set_score(start.score);
 
-    QLabel* score_label = new QLabel;
-    QString score_filename(":/image/score.png");
-    scoreImage = new QPixmap(score_filename);
-    score_label->setPixmap(*scoreImage);
-    progress_layout->addWidget(score_label);
-
-    scoreMessage = new QLabel;
-    scoreMessage->setText(QString::number(score));
-
-    scoreMessage->setFont(impact);
-    progress_layout->addWidget(scoreMessage);
-
-
-    //add progress layout to vertical layout
-    game_layout->addLayout(progress_layout);
+    //add header to vertical layout
+    game_layout->addWidget(hud);
 
     //add board to the vertical layout
-    game_layout->addWidget(Board,0,Qt::AlignCenter);
+    game_layout->addWidget(Board);
 
     //quit button
     //here, improve by popping up window to check for confirmation
     QPushButton* quit = new QPushButton("Quit");
-    quit->setStyleSheet("background-color: darkCyan");
+    quit->setStyleSheet(theme.quit_style);
     QObject::connect(quit, SIGNAL(clicked()), parent, SLOT(close()));
     //QObject::connect(quit, SIGNAL(clicked()), this, SLOT(quitDialog()));
 
@@ -168,10 +221,18 @@ GameBoard::GameBoard(QWidget *parent, size_t board_sz, int tm, bool moving_enem,
     game_layout->addWidget(quit);
 
     this->setLayout((game_layout));
-    this->setStyleSheet("QLabel { background-color : white;}");
 
     QObject::connect(this, SIGNAL(game_over()), parent, SLOT(game_over()));
 
+    //the shown heatmap is drawn again every couple of seconds, so it
+    //keeps up with this game and others without redrawing on every move
+    heat_timer = new QTimer(this);
+    heat_timer->setInterval(2000);
+    connect(heat_timer, SIGNAL(timeout()), this, SLOT(show_heat()));
+
+    //draw the starting board
+    update_board(start);
+
    /*while(!game_over())
     {
         if(player->state() == QMediaPlayer::PlayingState)
@@ -187,496 +248,184 @@ GameBoard::GameBoard(QWidget *parent, size_t board_sz, int tm, bool moving_enem,
 }
 
 /*
- *Function that creates a moving enemy. Enemy moves horizontally across screen,
- *based on timer, and if there is collision with bee then game is over. Enemy
- *appears at random spots on screen, new coordinates found using enemy_coordinates
- *function.
-*/
-void GameBoard::create_enemy()
+ * Function called on the simulation thread each time it publishes a frame.
+ * Asks the GUI thread to show it, unless it has already been asked and
+ * hasn't got to it yet; it will show the newest frame either way.
+ */
+void GameBoard::frame_ready()
 {
-    QString cloud_fileName(":/image/child.jpg");
-    cloud_image = new QPixmap(cloud_fileName);
-
-    std::uniform_int_distribution<int> unif(0,board_size - 1);
-    int x = unif(generator);
-    int y = unif(generator);
-
-    //add to get label number
-    int cloud_pos = (y*board_size) + x;
-
-    //set label to display cloud_image
-    labels[cloud_pos]->setPixmap(*cloud_image);
-    labels[cloud_pos]->setScaledContents(true);
-    labels[cloud_pos]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-    cloud_position = new QPoint(x,y);
-    vector_cloudPositions.push_back(cloud_position);
-
-    QTimer* timer = new QTimer;
-    timer->start(100);
-    connect(timer, SIGNAL(timeout()), this, SLOT(move_enemy()));
+    if(!frame_posted.exchange(true))
+        QMetaObject::invokeMethod(this, "show_frame", Qt::QueuedConnection);
 }
 
 /*
- * Function to move enemy around the screen. Done by incrementing x-coordinate
- * of enemy until the end of the board or another object has been reached.
- *
-*/
-void GameBoard::move_enemy()
+ * Function to show the newest frame from the simulation. Frames published
+ * while the GUI thread was busy are skipped.
+ */
+void GameBoard::show_frame()
 {
-    int x = cloud_position->rx();
-    int y = cloud_position->ry();
-    int new_cloud_pos;
-    bool end = false; //changes when end reached
-    //bool back_to_left = false;
-
-    int cloud_pos = (y*board_size) + x;
-    labels[cloud_pos]->clear();
-
-    //check if at rightmost end of board. If reached end, make end = true
-    if((x + 1) % board_size == 0 || (x + 1 == flower_position->rx() &&  y == flower_position->ry())
-            ||(x + 1 == hive_position->rx()&& y == hive_position->ry()))
-    {
-        end = true;
-    }
+    TRACE_SCOPE("show_frame");
 
-    //if reached end of screen, get new coordinates
-    if(end)
-    {
-        enemy_coordinates();
-        new_cloud_pos = (board_size* (cloud_position->ry())) + cloud_position->rx();
-    }
-
-    if(!end)
-        {
-            cloud_position->setX(x + 1);
-            new_cloud_pos = (board_size* (cloud_position->ry())) + cloud_position->rx();
-        }
-
-    //move image to next label
-    labels[new_cloud_pos]->setPixmap(*cloud_image);
-    labels[new_cloud_pos]->setScaledContents(true);
-    labels[new_cloud_pos]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-    //if enemy in same position as bee, game over
-    if(cloud_position->rx() ==  bee_position->rx() && cloud_position->ry() == bee_position->ry())
-    {
-        game_over();
-    }
+    frame_posted = false;
+    if(!sim->update())
+        return;
 
-    repaint();
+    const Simulation::Frame& f = sim->frame();
+    update_header(f);
+    update_board(f);
 }
 
 /*
- * Function to get random coordinates for enemy once end has been reached.
- * Checks to ensure coordinates don't match with coordinates of the other
- * objects on the board.
-*/
-void GameBoard::enemy_coordinates()
+ * Function to keep the sprites over their squares when the board is zoomed
+ * or panned. Sprites are only shown while the board draws pictures, and
+ * the minimap stays in front of them.
+ *
+ * @param origin is where square (0,0) is drawn
+ * @param side is how big squares are
+ */
+void GameBoard::view_changed(QPointF origin, qreal side)
 {
-    std::uniform_int_distribution<int> unif(0,board_size - 1);
-
-    int new_x = unif(generator);
-    int new_y = unif(generator);
-
-    //check if coordinates match with flower, bee, or hive
-    while((new_x == flower_position->rx() && new_y == flower_position->ry()) ||
-            (new_x == bee_position->rx()&& new_y == bee_position->ry()) ||
-            (new_x == hive_position->rx() && new_y == hive_position->ry()))
-    {
-        new_x = unif(generator);
-        new_y = unif(generator);
-    }
-
-    cloud_position->setX(new_x);
-    cloud_position->setY(new_y);
-
+    layer->set_view(origin, side);
+    layer->setVisible(Board->pictures_shown());
+    minimap->raise();
 }
 
 /*
- * Function to draw flowers on the board. Gets random x and y values and makes
- * sure values don't coordinates of the other elements. Then adds image of flower
- * to label corresponding to the coordinates.
- * If enough flowers have been drawn (depending on difficulty) then calls
- * drawOpp() function.
- *
+ * Function to draw the heatmap being shown over the board, or take it away
+ * if none is shown.
  */
-void GameBoard::setFlower()
-{   
-    //get random number from 0-9 for x and y coordinates
-    std::uniform_int_distribution<int> unif(0,board_size - 1);
-    int x = unif(generator);
-    int y = unif(generator);
-
-
-    //go through opp positions and make sure flower isn't in same place
-    for (size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
+void GameBoard::show_heat()
+{
+    if(heat_shown < 0)
     {
-        int opp_x = vector_oppPositions[i]->rx();
-        int opp_y = vector_oppPositions[i]->ry();
-
-        //same number of obstacles as opps so indices match
-        int obstacle_x, obstacle_y;
-
-        if(obstacles)
-        {
-            obstacle_x = vector_obstaclePositions[i]->rx();
-            obstacle_y = vector_obstaclePositions[i]->ry();
-        }
-
-        //if no obstacles then just set obstacle's position to same as bee so no problems in following check
-        if(!obstacles)
-        {
-            obstacle_x = bee_position->rx();
-            obstacle_y = bee_position->ry();
-        }
-
-        //check if flower position matches bee or hive position or the opp/obstacle positions
-        if ((x == bee_position->rx() && y == bee_position->ry()) || ((x == board_size - 1) && y == 0)||
-                (x == opp_x && y == opp_y) || (x == obstacle_x && y == obstacle_y))
-        {
-            x = unif(generator);
-            y = unif(generator);
-        }
+        heat_timer->stop();
+        Board->set_overlay(QImage());
+        return;
     }
 
-    flower_position = new QPoint(x,y);
-
-    //add to get label number
-    int flower_pos = (y*board_size) + x;
-
-    //set label to display flower_image
-    labels[flower_pos]->setPixmap(*flower_image);
-    labels[flower_pos]->setScaledContents(true);
-    labels[flower_pos]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-    //depending on level, if enough flowers collected, draw opponent
-    if(counter % opp_time == 0)
-    {
-        drawOpp();
-    }
+    heatmap->draw(heat_difficulty, heat_shown, Theme::standard().heat_color, heat_image);
+    Board->set_overlay(heat_image);
+    if(!heat_timer->isActive())
+        heat_timer->start();
 }
 
 /*
  * Destructor for GameBoard class.
- * Deletes the ui pointer
+ * Stops the simulation before anything it calls back into goes away,
+ * then the heatmap it adds to, then deletes the ui pointer
  */
 GameBoard::~GameBoard()
 {
+    delete sim;
+    delete heatmap;
     delete ui;
 }
 
 /*
- * Function to paint the board. Redraws the bee every time paintEvent is called.
- * Then redraws hive so if bee is in the same label as hive then the hive shows
- * (as if the bee whent into the hive)
+ * Function to show a frame on the board. The board only redraws squares
+ * whose piece is different from what it shows.
+ * The bee and cloud are not drawn by the board when squares are big enough
+ * for pictures; they are moved on the sprite layer instead, sliding one
+ * square or jumping when they go further.
+ * Emits game_over() the first time a frame says the game is over.
  *
- * @param e is QPaintEvent object called
+ * @param f is the frame to show
  */
-void GameBoard::paintEvent(QPaintEvent *e)
+void GameBoard::update_board(const Simulation::Frame& f)
 {
-    QPainter painter(this);
-    //painter.setWindow(0,0,100,100);
-    painter.setWindow(0,0,board_size - 1, board_size - 1);
-
-    //get x and y coordinates of bee
-    int x = bee_position->rx();
-    int y = bee_position->ry();
-
-    //redraw bee in new label
-    labels[y*board_size+x]->setPixmap(*bee_image);
-    labels[y*board_size+x]->setScaledContents(true);
-    labels[y*board_size+x]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-    //redraw hive so it is always on top in case bee goes to hive (so hive doesn't disappear)
-    labels[board_size-1]->setPixmap(*hive_image);
-    labels[board_size-1]->setScaledContents(true);
-    labels[board_size-1]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-    //redraw all the enemies
-    for(size_t i = 0, n = vector_oppPositions.size(); i < n; ++i)
+    Board->set_pieces(f.pieces, f.row_changed, board_frame);
+    board_frame = f.number;
+    Board->set_workers(f.workers);
+
+    //bee hides under the hive (or anything else drawn over it)
+    const Cell& bee = f.bee;
+    layer->move_sprite(bee_sprite, bee.x, bee.y, 80);
+    layer->set_sprite_visible(bee_sprite, f.pieces[bee.y*board_size + bee.x] == GameEngine::Bee);
+
+    //clouds slide along their path each tick, and jump when they start again somewhere else
+    const std::vector<Cell>& clouds = f.clouds;
+    const std::vector<Cell>& velocities = f.cloud_velocities;
+    while(cloud_sprites.size() < clouds.size())
+        cloud_sprites.push_back(layer->add_sprite(*cloud_image));
+    for(size_t i = 0, n = cloud_sprites.size(); i < n; i++)
     {
-        int enemy_x = vector_oppPositions[i]->rx();
-        int enemy_y = vector_oppPositions[i]->ry();
-        labels[(board_size * enemy_y) + enemy_x]->setPixmap(*opp_image);
-        labels[(board_size * enemy_y) + enemy_x]->setScaledContents(true);
-        labels[(board_size * enemy_y) + enemy_x]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+        if(i >= clouds.size())
+        {
+            layer->set_sprite_visible(cloud_sprites[i], false);
+            continue;
+        }
+
+        const Cell& cloud = clouds[i];
+        QPoint moved = QPoint(cloud.x, cloud.y) - layer->sprite_square(cloud_sprites[i]);
+        bool along_path = moved == QPoint(velocities[i].x, velocities[i].y) || moved.manhattanLength() == 1;
+        layer->move_sprite(cloud_sprites[i], cloud.x, cloud.y, along_path ? 100 : 0);
+        layer->set_sprite_visible(cloud_sprites[i], f.pieces[cloud.y*board_size + cloud.x] == GameEngine::Cloud);
     }
 
-    //if level has obstacles, redraw all obstacles
-    if(obstacles)
+    //with hold_game_over the game pauses at the end so it can be rewound,
+    //unless there is no history to rewind
+    if(f.over && !over_sent && !f.rewinding && hold_game_over && !f.rewind_off)
     {
-        //redraw all the obstacles
-        for(size_t i = 0, n = vector_obstaclePositions.size(); i < n; ++i)
-        {
-            int obstacle_x = vector_obstaclePositions[i]->rx();
-            int obstacle_y = vector_obstaclePositions[i]->ry();
-            labels[(board_size * obstacle_y) + obstacle_x]->setPixmap(*obstacle_image);
-            labels[(board_size * obstacle_y) + obstacle_x]->setScaledContents(true);
-            labels[(board_size * obstacle_y) + obstacle_x]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-        }
+        sim->send(Simulation::Rewind, 0);
+        return;
     }
 
-    //draw flower
-    int flower_x = flower_position->rx();
-    int flower_y = flower_position->ry();
-    labels[(board_size * flower_y) + flower_x]->setPixmap(*flower_image);
-    labels[(board_size * flower_y) + flower_x]->setScaledContents(true);
-    labels[(board_size * flower_y) + flower_x]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+    if(f.over && !over_sent && !f.rewinding)
+    {
+        over_sent = true;
+        trace::instant("game_over");
+        game_over();
+    }
 }
 
 /*
- * Function to move bee to new label
- * Checks conditions to make sure it is a valid move; otherwise
- * displays gameover message.
- * If bee moves to same label as a flower, updates counter and
- * progress bar.
+ * Function to update the progress bar, message and score at the top of
+ * the screen. The header only redraws what changed.
  *
- * @param prev_x is x coordinate of bee before it moves
- * @param prev_y is y coordinate of bee before it moves
- * @param next_x is x coordinate of bee after it moves
- * @param next_y is y coordinate of bee after it moves
+ * @param f is the frame to show
  */
-void GameBoard::moveBee(int prev_x, int prev_y, int next_x, int next_y)
+void GameBoard::update_header(const Simulation::Frame& f)
 {
-    //if new coordinates same as flower coordinates then increment count
-    if (next_x == flower_position->rx() && next_y == flower_position->ry())
-    {
-        counter++;
-        //increase progress bar by 10%
-        progress->setValue(counter * 10);
-    }
-
-    //if progress bar full, show fullMessage
-    if(progress->value() == 100)
-    {
-        fullMessage->setText("Time to visit the hive!");
-        //QFont("Impact", 12);
-        fullMessage->setFont(QFont("Impact", 10));
-        fullMessage->setStyleSheet("QLabel { color : red;}");
-    }
-
-    //otherwise no message
+    hud->set_progress(f.progress);
+
+    //one for each GameEngine::Move
+    static const char* const hints[] = { "Hint: stay put", "Hint: go left", "Hint: go right", "Hint: go up",
+                                         "Hint: go down" };
+
+    //one for each GameEngine::HeatKind
+    static const char* const heatmaps[] = { "Heatmap: squares visited", "Heatmap: flowers picked",
+                                            "Heatmap: games lost" };
+
+    //if the game is held at game over, say how to rewind; then a hint if
+    //one was asked for, then which heatmap is shown; if progress bar full,
+    //show message; if there is no rewind history, say so; in swarm mode
+    //show the workers' pollen, otherwise no message
+    if(f.over && f.rewinding)
+        hud->set_message("Game over: [ and ] to rewind, Esc to end");
+    else if(f.hint >= 0)
+        hud->set_message(hints[f.hint]);
+    else if(heat_shown >= 0)
+        hud->set_message(heatmaps[heat_shown]);
+    else if(f.hive_ready)
+        hud->set_message("Time to visit the hive!");
+    else if(f.rewind_off)
+        hud->set_message("Rewind off: too many enemies to keep");
+    else if(!f.workers.empty())
+        hud->set_message(QString("Swarm pollen: %1").arg(f.swarm_pollen));
     else
-    {
-        fullMessage->setText(" ");
-    }
-
-    //bee can't move if there is an obstacle
-    if(obstacles)
-    {
-        for(size_t i = 0, n = vector_obstaclePositions.size(); i < n; i++)
-        {
-            if (next_x == vector_obstaclePositions[i]->rx() && next_y == vector_obstaclePositions[i]->ry())
-               {
-                bee_position->setX(prev_x);
-                bee_position->setY(prev_y);
-                return;
-               }
-        }
-    }
+        hud->set_message(QString());
 
-    //clear bee's position
-    labels[prev_y*board_size+prev_x]->clear();
-
-    //change coordinates of bee
-    bee_position->setX(next_x);
-    bee_position->setY(next_y);
-
-    //if new coordinates same as flower, have to set new flower
-    if (next_x == flower_position->rx() && next_y == flower_position->ry())
-    {
-        setFlower();
-    }
-
-    //if bee in same position as opp, game over
-    for(size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
-    {
-        if (next_x == vector_oppPositions[i]->rx() && next_y == vector_oppPositions[i]->ry())
-           {
-            this->game_over();
-           }
-    }
-
-    //if be runs into moving cloud then game over
-    for(size_t i = 0, n = vector_cloudPositions.size(); i < n; i++)
-    {
-        if (next_x == vector_cloudPositions[i]->rx() && next_y == vector_cloudPositions[i]->ry())
-        {
-            this->game_over();
-        }
-    }
-
-
-    //if bee in hive and enough has pollen, increase progress bar
-    //if progress bar full, dump pollen
-    if(next_x == hive_position->rx() && next_y == hive_position->ry() && progress->value() == 100)
-    {
-        counter = counter % 10;
-
-        //reset progress bar
-        progress->setValue(0);
-
-        //increase score, update score display
-        ++score;
-        scoreMessage->setText(QString::number(score));
-
-        //if score big enough, get rid of some clouds
-        if(score % 1 == 0 && score != 0)
-        {
-            int x, y;
-            int obstacle_x, obstacle_y;
-
-            int size = vector_oppPositions.size() - 1;
-            int num_removed;
-
-            //if easy level, remove 1 enemy
-            if(!obstacles && !moving_enemies)
-                num_removed = 1;
-            if(obstacles && !moving_enemies)
-                num_removed = 2;
-            if(obstacles && moving_enemies)
-                num_removed = 4;
-
-            //get rid of clouds, number depends on level
-            for(size_t i = 0; i < num_removed; i++)
-            {
-                //remove opp image from the board
-                x = vector_oppPositions[size - i]->rx();
-                y = vector_oppPositions[size - i]->ry();
-                labels[board_size*y + x]->clear();
-
-                //remove opp's point from the vector
-                vector_oppPositions.pop_back();
-
-                //if level has obstacles, also remove obstacles
-                if(obstacles)
-                {
-                    //remove obstacle image from the board
-                    obstacle_x = vector_obstaclePositions[size - i]->rx();
-                    obstacle_y = vector_obstaclePositions[size - i]->ry();
-                    labels[board_size*obstacle_y + obstacle_x]->clear();
-
-                    //remove opp's point from the vector
-                    vector_obstaclePositions.pop_back();
-                }
-            }
-
-            repaint();
-        }
-
-    }
+    hud->set_score(f.score);
 }
 
 /*
- * Function to draw the green clouds (opponents). Checks if
- * enough flowers have been collected to draw another opponent.
- * Gets random coordinates and ensures they don't match coordinates
- * of other elements, then draws the opponent on the board.
+ * Function to get the score, used by the game over screen.
+ *
+ * @return number of times pollen was dropped off at the hive
  */
-void GameBoard::drawOpp()
+size_t GameBoard::get_score() const
 {
-    //used to get random coordinates
-    std::uniform_int_distribution<int> unif(0,board_size - 1);
-
-    //if right amount of time has passed, draw a new opp
-    if (counter == 0)
-        return;
-
-    //frequency of opp appearance depends on level (opp_time)
-    if(counter % opp_time == 0)
-    {
-        //get random coordinates for opp and obstacle
-        int x = unif(generator);
-        int y = unif(generator);
-        int obstacle_x = unif(generator);
-        int obstacle_y = unif(generator);
-
-        //if no obstacles then just set obstacle coordinates same as bee
-        if(!obstacles)
-        {
-            obstacle_x = bee_position->rx();
-            obstacle_y = bee_position->ry();
-
-        }
-
-        //if level has obstacles, make sure coordinates don't match
-        if(obstacles)
-        {
-            //go through vector of opps and check if coordinates match
-            for(size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
-            {
-                int opp_x = vector_oppPositions[i]->rx();
-                int opp_y = vector_oppPositions[i]->ry();
-
-                if(obstacle_x == opp_x && obstacle_y == opp_y)
-                {
-                    obstacle_x = unif(generator);
-                    obstacle_y = unif(generator);
-                }
-            }
-
-            //check if obstacle matches coordinates of other objects
-            while ((obstacle_x == bee_position->rx() && obstacle_y == bee_position->ry()) || (obstacle_x == hive_position->rx()
-            && obstacle_y == hive_position->ry()) || (obstacle_x == flower_position->rx() && obstacle_y == flower_position->ry()))
-            {
-                obstacle_x = unif(generator);
-                obstacle_y = unif(generator);
-            }
-        }
-
-        //go through vector of obstacles and make sure coordinates don't match w/ opp
-        if(obstacles)
-        {
-            for(size_t i = 0, n = vector_obstaclePositions.size(); i < n; i++)
-            {
-                int ob_x = vector_obstaclePositions[i]->rx();
-                int ob_y = vector_obstaclePositions[i]->ry();
-
-                //if coordinates match, get new coordinates
-                if(x == ob_x && y == ob_y)
-                {
-                    x = unif(generator);
-                    y = unif(generator);
-                }
-            }
-        }
-
-        //make sure coordinates not same as other objects
-        while ((x == bee_position->rx() && y == bee_position->ry()) || (x == hive_position->rx()
-        && y == hive_position->ry()) || (x == flower_position->rx() && y == flower_position->ry())
-               || (x == obstacle_x && y == obstacle_y))
-        {
-            x = unif(generator);
-            y = unif(generator);
-        }
-
-        int opp_pos = y*board_size + x;
-        int obstacle_pos = obstacle_y*board_size + obstacle_x;
-
-        //set label to display opp_image
-        labels[opp_pos]->setPixmap(*opp_image);
-        labels[opp_pos]->setScaledContents(true);
-        labels[opp_pos]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-        //if level has obstacles, display obstacle
-        if(obstacles)
-        {
-            //set label to display obstacle_image
-            labels[obstacle_pos]->setPixmap(*obstacle_image);
-            labels[obstacle_pos]->setScaledContents(true);
-            labels[obstacle_pos]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-            obstacle_position = new QPoint(obstacle_x,obstacle_y);
-            vector_obstaclePositions.push_back((obstacle_position));
-        }
-
-        opp_position = new QPoint(x,y);
-        vector_oppPositions.push_back((opp_position));
-
-        num_opps++;
-
-    }
+    return sim->frame().score;
 }
 
 
@@ -687,51 +436,71 @@ void GameBoard::drawOpp()
  */
 void GameBoard::keyPressEvent(QKeyEvent *event)
 {
-    this->setFocus();
+    TRACE_SCOPE("keyPressEvent");
 
-    //get x and y coordinates of bee
-    int x = bee_position->rx();
-    int y = bee_position->ry();
+    this->setFocus();
 
+    //moves go to the simulation thread, which sends back a frame if anything
+    //changed. An arrow key while rewinding carries on from the tick being shown
     switch (event->key()) {
     case Qt::Key_Left:
-        if(x != 0)
-        {
-            this->moveBee(x,y, x-1, y);
-        }
-
-        break;
+        sim->send(Simulation::Press, GameEngine::Left);
+        return;
     case Qt::Key_Right:
-        //rightPressed = true;
-            if(x != board_size-1)
-            {
-                this->moveBee(x,y, x+1, y);
-            }
-        break;
+        sim->send(Simulation::Press, GameEngine::Right);
+        return;
     case Qt::Key_Up:
-        if(y != 0)
-        {
-            this->moveBee(x,y, x, y-1);
-        }
-        break;
+        sim->send(Simulation::Press, GameEngine::Up);
+        return;
     case Qt::Key_Down:
-        if(y != board_size-1)
+        sim->send(Simulation::Press, GameEngine::Down);
+        return;
+
+    //H asks for a hint, shown until the bee next moves
+    case Qt::Key_H:
+        sim->send(Simulation::Hint);
+        return;
+
+    //V shows each heatmap of this difficulty in turn, then none
+    case Qt::Key_V:
+        if(!heatmap->is_open())
+            return;
+        heat_shown = heat_shown + 1 < GameEngine::HeatKinds ? heat_shown + 1 : -1;
+        show_heat();
+        update_header(sim->frame());
+        return;
+
+    //F9 writes out the trace so far (if tracing is on)
+    case Qt::Key_F9:
+        trace::flush();
+        return;
+
+    //[ and ] step back and forward through the last few minutes; the first
+    //step back pauses the game until an arrow key is pressed
+    case Qt::Key_BracketLeft:
+        sim->send(Simulation::Rewind, -1);
+        return;
+    case Qt::Key_BracketRight:
+        sim->send(Simulation::Rewind, 1);
+        return;
+
+    //Esc ends a game that was held at game over
+    case Qt::Key_Escape:
+        if(hold_game_over && sim->frame().over && !over_sent)
         {
-            this->moveBee(x,y, x, y+1);
+            over_sent = true;
+            game_over();
         }
-
-        break;
+        return;
 
     default:
         QWidget::keyPressEvent(event);
+        return;
     }
-
-    repaint();
-    QCoreApplication::processEvents();
 }
 
 /*
- * Function to show the effects of paintEvent and keyPressEvent on the board.
+ * Function to show the effects of keyPressEvent on the board.
  *
  * @param e processes events and shows them on board.
  */
@@ -19,7 +19,16 @@
 #include <QPaintEvent>
 #include <QKeyEvent>
 #include <vector>
-#include <QProgressBar>
+#include "gameengine.h"
+#include "hud.h"
+#include "spritelayer.h"
+#include "boardview.h"
+#include "minimap.h"
+#include "simulation.h"
+#include "heatmap.h"
+#include <QImage>
+#include <QTimer>
+#include <atomic>
 
 namespace Ui {
 class GameBoard;
@@ -38,29 +47,41 @@ signals:
     void game_over();
 
 public slots:
-    void move_enemy();
+    void show_frame();
+    void view_changed(QPointF origin, qreal side);
+    void show_heat();
 
 public:
     explicit GameBoard(QWidget *parent = 0, size_t board_size = 15, int opp_time = 5, bool moving_enemies = true, bool obstacles = true);
     ~GameBoard();
-    void paintEvent(QPaintEvent *e);
     void showEvent(QShowEvent *e);
     void keyPressEvent(QKeyEvent *event);
 
+    //functions to draw the elements on the board
+    void frame_ready();
+    void update_board(const Simulation::Frame& f);
+    void update_header(const Simulation::Frame& f);
 
-    //functions to draw/move the elements on the board
-    void moveBee(int prev_x, int prev_y, int next_x, int next_y);
-    void setFlower();
-    void drawOpp();
-
-    void create_enemy();
-    void enemy_coordinates();
-
-    size_t score;
+    size_t get_score() const;
 
 private:
     Ui::GameBoard *ui;
 
+    //the game, running on its own thread, and the newest frame it sent
+    Simulation* sim;
+    std::atomic<bool> frame_posted; //whether show_frame() is already waiting to run
+    uint64_t board_frame; //number of the frame the board last showed
+    bool over_sent; //whether game_over() has been emitted
+    bool hold_game_over; //stay on the board at game over so it can be rewound
+
+    //counts of where bees go and die, from every game played, and which
+    //GameEngine::HeatKind is shown over the board (-1 for none)
+    Heatmap* heatmap;
+    int heat_difficulty;
+    int heat_shown;
+    QImage heat_image;
+    QTimer* heat_timer; //redraws the shown heatmap while it is shown
+
     //graphics
     QPixmap* bee_image;
     QPixmap* hive_image;
@@ -69,33 +90,19 @@ private:
     QPixmap* cloud_image;
     QPixmap* obstacle_image;
 
-    //positions of characters
-    QPoint* bee_position;
-    QPoint* hive_position;
-    QPoint* flower_position;
-    QPoint* opp_position;
-    QPoint* cloud_position;
-    QPoint* obstacle_position;
-
-    //displays at top of screen
-    QProgressBar* progress;
-    QLabel* fullMessage; //displays message when progress bar full
-    QLabel* scoreMessage;
+    //displays at top of screen: progress bar, message when it is full, and score
+    Hud* hud;
     QPixmap* scoreImage;
 
-    //vector to store all opp positions
-    std::vector<QPoint*> vector_oppPositions;
-    std::vector<QPoint*> vector_obstaclePositions;
-    std::vector<QPoint*> vector_cloudPositions;
-
-    size_t counter; //number of flowers visited
-    //size_t score;
-    size_t num_opps; //number of opponents
-
     //Board variables
-    QWidget* Board;
+    BoardView* Board;
     size_t board_size;
-    QLabel** labels;
+    Minimap* minimap; //shown in the corner while zoomed in
+
+    //bee and cloud are drawn over the board so they can slide between squares
+    SpriteLayer* layer;
+    int bee_sprite;
+    std::vector<int> cloud_sprites; //one per enemy, added as the engine adds enemies
     int opp_time; //determines difficulty
 
     bool moving_enemies; //whether there's moving enemy
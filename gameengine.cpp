@@ -0,0 +1,824 @@
+/*
+ * @file gameengine.cpp
+ * @brief contains class definition of GameEngine class
+ *
+ * This file defines the rules of the game. The bee and hive start in
+ * diagonally opposite corners, flowers appear at random, and opps (and
+ * obstacles on the harder levels) appear as flowers are collected. These
+ * are the same rules GameBoard used to apply directly to its labels.
+ */
+
+#include "gameengine.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdlib>
+
+/*
+ * Constructor for the GameEngine class.
+ *
+ * @param board_sz is size of board
+ * @param tm is how many flowers are collected between opps
+ * @param moving_enem is whether the level has a moving cloud
+ * @param obst is whether the level has obstacles
+ * @param seed seeds the random placement of flowers, opps and clouds
+*/
+GameEngine::GameEngine(size_t board_sz, int tm, bool moving_enem, bool obst, unsigned seed) :
+    enemy_behaviour(-1), board_size(board_sz), opp_time(tm), moving_enemies(moving_enem), obstacles(obst),
+    reach(board_sz), heat(0), metrics(0)
+{
+    reset(seed);
+}
+
+/*
+ * Function to start a new game. Puts the bee and hive back in their corners,
+ * removes all opps and obstacles, and sets a new flower (and cloud if the
+ * level has one).
+ *
+ * @param sd seeds the random placement for this game
+ */
+void GameEngine::reset(unsigned sd)
+{
+    seed = sd;
+    ticks = 0;
+    flowers_placed = 0;
+    opps_placed = 0;
+
+    counter = 0;
+    score = 0;
+    num_opps = 0;
+    progress = 0;
+    over = false;
+    flower_ns = 0;
+    ready_ns = 0;
+
+    vector_oppPositions.clear();
+    vector_obstaclePositions.clear();
+    vector_cloudPositions.clear();
+    vector_cloudVelocities.clear();
+    vector_cloudBehaviours.clear();
+    vector_cloudMemory.clear();
+    reach.clear();
+
+    //every square needs redrawing
+    changed.clear();
+    for(size_t i = 0; i < board_size*board_size; i++)
+        changed.push_back(i);
+
+    //bee at top left corner, hive at top right corner
+    bee_position = Cell{0, 0};
+    hive_position = Cell{static_cast<int>(board_size) - 1, 0};
+
+    //set flower to random place on grid
+    setFlower();
+
+    //create enemy if correct level
+    if(moving_enemies)
+        create_enemy();
+}
+
+/*
+ * Function to copy everything that changes during a game.
+ *
+ * @param s receives the copy
+ */
+void GameEngine::save(Snapshot& s) const
+{
+    s.bee = bee_position;
+    s.flower = flower_position;
+    s.opps = vector_oppPositions;
+    s.obstacles = vector_obstaclePositions;
+    s.clouds = vector_cloudPositions;
+    s.cloud_velocities = vector_cloudVelocities;
+    s.cloud_behaviours = vector_cloudBehaviours;
+    s.cloud_memory = vector_cloudMemory;
+    s.counter = counter;
+    s.score = score;
+    s.num_opps = num_opps;
+    s.progress = progress;
+    s.over = over;
+    s.seed = seed;
+    s.ticks = ticks;
+    s.flowers_placed = flowers_placed;
+    s.opps_placed = opps_placed;
+}
+
+/*
+ * Function to go back to a copy made by save(). The game continues from
+ * there exactly as it did (or would have) the first time.
+ *
+ * @param s is the copy to go back to
+ */
+void GameEngine::load(const Snapshot& s)
+{
+    bee_position = s.bee;
+    flower_position = s.flower;
+    vector_oppPositions = s.opps;
+    vector_obstaclePositions = s.obstacles;
+    vector_cloudPositions = s.clouds;
+    vector_cloudVelocities = s.cloud_velocities;
+    vector_cloudBehaviours = s.cloud_behaviours;
+    vector_cloudMemory = s.cloud_memory;
+    counter = s.counter;
+    score = s.score;
+    num_opps = s.num_opps;
+    progress = s.progress;
+    over = s.over;
+    seed = s.seed;
+    ticks = s.ticks;
+    flowers_placed = s.flowers_placed;
+    opps_placed = s.opps_placed;
+    flower_ns = 0;
+    ready_ns = 0;
+    rebuild_reach();
+
+    changed.clear();
+    for(size_t i = 0; i < board_size*board_size; i++)
+        changed.push_back(i);
+}
+
+/*
+ * Function to block the squares of every opp and obstacle again, in the
+ * order they were put down.
+ */
+void GameEngine::rebuild_reach()
+{
+    reach.clear();
+    for(size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
+    {
+        if(obstacles && i < vector_obstaclePositions.size())
+            reach.block(vector_obstaclePositions[i].x, vector_obstaclePositions[i].y);
+        reach.block(vector_oppPositions[i].x, vector_oppPositions[i].y);
+    }
+}
+
+/*
+ * Function to set the progress bar value. Like QProgressBar, values
+ * outside 0-100 are ignored.
+ *
+ * @param value is new value of the progress bar
+ */
+void GameEngine::set_progress(int value)
+{
+    if(value >= 0 && value <= 100)
+        progress = value;
+}
+
+/*
+ * Function to remember that a square has to be redrawn.
+ *
+ * @param x is x coordinate of the square
+ * @param y is y coordinate of the square
+ */
+void GameEngine::mark(int x, int y)
+{
+    changed.push_back(y*board_size + x);
+}
+
+/*
+ * Function that responds to a move, the same way keyPressEvent responds to
+ * the arrow keys. Moves off the edge of the board are ignored.
+ *
+ * @param m is the direction to move
+ * @return true if moveBee was called
+ */
+bool GameEngine::press(Move m)
+{
+    if(over)
+        return false;
+
+    //get x and y coordinates of bee
+    int x = bee_position.x;
+    int y = bee_position.y;
+    int last = board_size - 1;
+
+    switch (m) {
+    case Left:
+        if(x == 0)
+            return false;
+        moveBee(x,y, x-1, y);
+        return true;
+    case Right:
+        if(x == last)
+            return false;
+        moveBee(x,y, x+1, y);
+        return true;
+    case Up:
+        if(y == 0)
+            return false;
+        moveBee(x,y, x, y-1);
+        return true;
+    case Down:
+        if(y == last)
+            return false;
+        moveBee(x,y, x, y+1);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ *Function that creates a moving enemy. Enemy moves horizontally across screen,
+ *one square each time move_enemy is called, and if there is collision with
+ *bee then game is over. Enemy appears at random spots on screen, new
+ *coordinates found using enemy_coordinates function.
+*/
+void GameEngine::create_enemy()
+{
+    CounterRng rng = stream(CounterRng::Enemy, vector_cloudPositions.size());
+    int x = rng.below(board_size);
+    int y = rng.below(board_size);
+
+    add_enemy(x, y, 1, 0, enemy_behaviour);
+}
+
+/*
+ * Function to add a moving enemy with its own speed and direction.
+ *
+ * @param x is x coordinate the enemy starts at
+ * @param y is y coordinate the enemy starts at
+ * @param vx is squares moved right each tick (negative for left)
+ * @param vy is squares moved down each tick (negative for up); if both are
+ * non-zero they must be the same size, so the enemy moves diagonally
+ * @param behaviour is the script that steers it (see add_behaviour), or -1
+ * to keep the same velocity
+ */
+void GameEngine::add_enemy(int x, int y, int vx, int vy, int behaviour)
+{
+    vector_cloudPositions.push_back(Cell{x, y});
+    vector_cloudVelocities.push_back(Cell{vx, vy});
+    vector_cloudBehaviours.push_back(behaviour);
+    vector_cloudMemory.push_back(0);
+    mark(x, y);
+}
+
+/*
+ * Function to add an enemy behaviour. Each tick, before enemies move, the
+ * script is run for every enemy that has the behaviour and sets their
+ * velocities.
+ *
+ * @param script is a compiled EnemyScript
+ * @return the behaviour's number, for add_enemy and set_enemy_behaviour
+ */
+int GameEngine::add_behaviour(const EnemyScript& script)
+{
+    behaviours.push_back(script);
+    return behaviours.size() - 1;
+}
+
+/*
+ * Function to run every behaviour's script, once for all the enemies that
+ * have it. Velocities are kept to the size of the board, so no enemy tries
+ * to go further than it could.
+ */
+void GameEngine::run_behaviours()
+{
+    int limit = board_size;
+
+    for(size_t b = 0; b < behaviours.size(); b++)
+    {
+        lanes.clear();
+        for(size_t i = 0, n = vector_cloudBehaviours.size(); i < n; i++)
+        {
+            if(vector_cloudBehaviours[i] == int(b))
+                lanes.push_back(i);
+        }
+        if(lanes.empty())
+            continue;
+
+        const EnemyScript& script = behaviours[b];
+        size_t n = lanes.size();
+        vm.load(script, n);
+
+        int32_t* x = vm.lane(EnemyScript::X);
+        int32_t* y = vm.lane(EnemyScript::Y);
+        int32_t* vx = vm.lane(EnemyScript::VX);
+        int32_t* vy = vm.lane(EnemyScript::VY);
+        int32_t* mem = vm.lane(EnemyScript::Mem);
+        int32_t* id = vm.lane(EnemyScript::Id);
+        for(size_t k = 0; k < n; k++)
+        {
+            size_t i = lanes[k];
+            x[k] = vector_cloudPositions[i].x;
+            y[k] = vector_cloudPositions[i].y;
+            vx[k] = vector_cloudVelocities[i].x;
+            vy[k] = vector_cloudVelocities[i].y;
+            mem[k] = vector_cloudMemory[i];
+            id[k] = i;
+        }
+        vm.set_all(EnemyScript::BeeX, bee_position.x);
+        vm.set_all(EnemyScript::BeeY, bee_position.y);
+        vm.set_all(EnemyScript::Tick, int32_t(ticks));
+        vm.set_all(EnemyScript::Size, board_size);
+
+        vm.run(script, seed, ticks);
+
+        for(size_t k = 0; k < n; k++)
+        {
+            size_t i = lanes[k];
+            vector_cloudVelocities[i] = Cell{std::max(-limit, std::min(limit, vx[k])),
+                                             std::max(-limit, std::min(limit, vy[k]))};
+            vector_cloudMemory[i] = mem[k];
+        }
+
+        const std::vector<uint32_t>& spawns = vm.spawns();
+        for(size_t k = 0; k < spawns.size(); k++)
+            spawn_enemy(b);
+    }
+}
+
+/*
+ * Function to add an enemy for a script's spawn. It starts somewhere away
+ * from the flower, bee and hive, like an enemy that reached the edge.
+ * Once there are as many enemies as squares, spawn does nothing.
+ *
+ * @param behaviour is the behaviour of the enemy that spawned it
+ */
+void GameEngine::spawn_enemy(int behaviour)
+{
+    size_t i = vector_cloudPositions.size();
+    if(i >= board_size*board_size)
+        return;
+
+    vector_cloudPositions.push_back(Cell{0, 0});
+    vector_cloudVelocities.push_back(Cell{1, 0});
+    vector_cloudBehaviours.push_back(behaviour);
+    vector_cloudMemory.push_back(0);
+    enemy_coordinates(i);
+    mark(vector_cloudPositions[i].x, vector_cloudPositions[i].y);
+}
+
+/*
+ * Function to check if an enemy can't move into a square: the edge of the
+ * board, the flower, the hive, an opp or an obstacle.
+ */
+bool GameEngine::stops_enemy(int x, int y) const
+{
+    int last = board_size - 1;
+    if(x < 0 || y < 0 || x > last || y > last)
+        return true;
+
+    return (x == flower_position.x && y == flower_position.y) || (x == hive_position.x && y == hive_position.y)
+            || reach.blocked(x, y);
+}
+
+/*
+ * Function to move every enemy one tick. Each enemy covers all the squares
+ * between where it is and where its speed takes it, not just the one it
+ * lands on:
+ *  - if the bee is on any of them before something stops the enemy, the
+ *    enemy stops on the bee and the game is over
+ *  - if the edge, flower, hive, an opp or an obstacle is in the way, the
+ *    enemy starts again somewhere else (see enemy_coordinates)
+ *  - otherwise it moves the whole way.
+ * Whether the bee is on the path is worked out directly from the bee's
+ * position, so only the squares checked for things in the way are visited.
+ * Enemies with a behaviour have their velocity set by its script first.
+*/
+void GameEngine::move_enemy()
+{
+    TRACE_SCOPE("move_enemy");
+
+    ticks++;
+
+    //scripts steer their enemies (and may add some) before anything moves
+    run_behaviours();
+
+    for(size_t i = 0, n = vector_cloudPositions.size(); i < n && !over; i++)
+    {
+        Cell& cloud_position = vector_cloudPositions[i];
+        const Cell& v = vector_cloudVelocities[i];
+
+        int speed = std::max(std::abs(v.x), std::abs(v.y));
+        if(speed == 0)
+            continue;
+        int dx = (v.x > 0) - (v.x < 0);
+        int dy = (v.y > 0) - (v.y < 0);
+
+        int x = cloud_position.x;
+        int y = cloud_position.y;
+        mark(x, y);
+
+        //how many steps along the path the bee is, 0 if it isn't on it
+        int bee_step = 0;
+        int bx = bee_position.x - x;
+        int by = bee_position.y - y;
+        int t = dx != 0 ? bx*dx : by*dy;
+        if(t >= 1 && t <= speed && bx == dx*t && by == dy*t)
+            bee_step = t;
+
+        //first step that is blocked, speed + 1 if none is
+        int stop = speed + 1;
+        int steps = bee_step ? bee_step : speed;
+        for(int k = 1; k <= steps; k++)
+        {
+            if(stops_enemy(x + dx*k, y + dy*k))
+            {
+                stop = k;
+                break;
+            }
+        }
+
+        //if enemy reaches the bee, game over
+        if(bee_step && bee_step < stop)
+        {
+            cloud_position = bee_position;
+            over = true;
+            note_loss(bee_position.x, bee_position.y);
+        }
+        //if reached end of screen or something in the way, get new coordinates
+        else if(stop <= speed)
+        {
+            enemy_coordinates(i);
+        }
+        else
+        {
+            cloud_position.x = x + dx*speed;
+            cloud_position.y = y + dy*speed;
+        }
+
+        mark(cloud_position.x, cloud_position.y);
+    }
+}
+
+/*
+ * Function to get random coordinates for enemy once end has been reached.
+ * Checks to ensure coordinates don't match with coordinates of the other
+ * objects on the board.
+ *
+ * @param i is the enemy to move
+*/
+void GameEngine::enemy_coordinates(size_t i)
+{
+    CounterRng rng = stream(CounterRng::EnemyRespawn, i);
+
+    int new_x = rng.below(board_size);
+    int new_y = rng.below(board_size);
+
+    //check if coordinates match with flower, bee, or hive
+    while((new_x == flower_position.x && new_y == flower_position.y) ||
+            (new_x == bee_position.x && new_y == bee_position.y) ||
+            (new_x == hive_position.x && new_y == hive_position.y))
+    {
+        new_x = rng.below(board_size);
+        new_y = rng.below(board_size);
+    }
+
+    vector_cloudPositions[i] = Cell{new_x, new_y};
+}
+
+/*
+ * Function to put a flower on the board. Gets random x and y values and makes
+ * sure values don't coordinates of the other elements.
+ * If enough flowers have been collected (depending on difficulty) then calls
+ * drawOpp() function.
+ *
+ */
+void GameEngine::setFlower()
+{
+    TRACE_SCOPE("setFlower");
+
+    CounterRng rng = stream(CounterRng::Flower, flowers_placed++);
+    int x = rng.below(board_size);
+    int y = rng.below(board_size);
+    int last = board_size - 1;
+
+    //go through opp positions and make sure flower isn't in same place
+    for (size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
+    {
+        int opp_x = vector_oppPositions[i].x;
+        int opp_y = vector_oppPositions[i].y;
+
+        //same number of obstacles as opps so indices match
+        //if no obstacles then just use bee's position so no problems in following check
+        int obstacle_x = bee_position.x;
+        int obstacle_y = bee_position.y;
+
+        if(obstacles)
+        {
+            obstacle_x = vector_obstaclePositions[i].x;
+            obstacle_y = vector_obstaclePositions[i].y;
+        }
+
+        //check if flower position matches bee or hive position or the opp/obstacle positions
+        if ((x == bee_position.x && y == bee_position.y) || (x == last && y == 0) ||
+                (x == opp_x && y == opp_y) || (x == obstacle_x && y == obstacle_y))
+        {
+            x = rng.below(board_size);
+            y = rng.below(board_size);
+        }
+    }
+
+    //never on an opp or obstacle, the bee or the hive, so it can always be reached
+    size_t tries = 0;
+    while ((reach.blocked(x, y) || (x == bee_position.x && y == bee_position.y) || (x == last && y == 0))
+           && ++tries < 4*board_size*board_size)
+    {
+        x = rng.below(board_size);
+        y = rng.below(board_size);
+    }
+
+    //board is nearly full, use the first free square
+    for(int i = 0; tries >= 4*board_size*board_size && i < int(board_size*board_size); i++)
+    {
+        x = i % board_size;
+        y = i / board_size;
+        if(!reach.blocked(x, y) && !(x == bee_position.x && y == bee_position.y) && !(x == last && y == 0))
+            break;
+    }
+
+    flower_position = Cell{x, y};
+    mark(x, y);
+
+    //depending on level, if enough flowers collected, draw opponent
+    if(counter % opp_time == 0)
+    {
+        drawOpp();
+    }
+}
+
+/*
+ * Function to count a lost game in the heatmap and metrics.
+ *
+ * @param x and y are the square the bee was lost on
+ */
+void GameEngine::note_loss(int x, int y)
+{
+    add_heat(HeatDeaths, x, y);
+    if(metrics)
+    {
+        metrics->losses.add();
+        metrics->opps_at_loss.record(vector_oppPositions.size());
+    }
+}
+
+/*
+ * Function to move bee to a new square.
+ * Checks conditions to make sure it is a valid move; the game is over if
+ * the bee moves onto an opp or the cloud.
+ * If bee moves to same square as a flower, updates counter and
+ * progress bar. If bee reaches the hive with a full progress bar, the
+ * pollen is dropped off, the score goes up and some opps are removed.
+ *
+ * @param prev_x is x coordinate of bee before it moves
+ * @param prev_y is y coordinate of bee before it moves
+ * @param next_x is x coordinate of bee after it moves
+ * @param next_y is y coordinate of bee after it moves
+ */
+void GameEngine::moveBee(int prev_x, int prev_y, int next_x, int next_y)
+{
+    TRACE_SCOPE("moveBee");
+
+    //if new coordinates same as flower coordinates then increment count
+    if (next_x == flower_position.x && next_y == flower_position.y)
+    {
+        counter++;
+        //increase progress bar by 10%
+        set_progress(counter * 10);
+    }
+
+    //bee can't move if there is an obstacle
+    if(obstacles)
+    {
+        for(size_t i = 0, n = vector_obstaclePositions.size(); i < n; i++)
+        {
+            if (next_x == vector_obstaclePositions[i].x && next_y == vector_obstaclePositions[i].y)
+                return;
+        }
+    }
+
+    //change coordinates of bee
+    mark(prev_x, prev_y);
+    bee_position = Cell{next_x, next_y};
+    mark(next_x, next_y);
+    add_heat(HeatVisits, next_x, next_y);
+
+    //if new coordinates same as flower, have to set new flower
+    if (next_x == flower_position.x && next_y == flower_position.y)
+    {
+        add_heat(HeatFlowers, next_x, next_y);
+        if(metrics)
+        {
+            uint64_t now = trace::now_ns();
+            metrics->flowers.add();
+            if(flower_ns)
+                metrics->flower_gap_ns.record(now - flower_ns);
+            flower_ns = now;
+            if(progress == 100 && !ready_ns)
+                ready_ns = now;
+        }
+        setFlower();
+    }
+
+    //if bee in same position as opp, game over
+    for(size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
+    {
+        if (next_x == vector_oppPositions[i].x && next_y == vector_oppPositions[i].y)
+            over = true;
+    }
+
+    //if bee runs into moving cloud then game over
+    for(size_t i = 0, n = vector_cloudPositions.size(); i < n; i++)
+    {
+        if (next_x == vector_cloudPositions[i].x && next_y == vector_cloudPositions[i].y)
+            over = true;
+    }
+    if(over)
+        note_loss(next_x, next_y);
+
+    //if bee in hive and enough has pollen, dump pollen
+    if(next_x == hive_position.x && next_y == hive_position.y && progress == 100)
+    {
+        counter = counter % 10;
+
+        //reset progress bar
+        progress = 0;
+
+        if(metrics)
+        {
+            metrics->deliveries.add();
+            if(ready_ns)
+                metrics->hive_delay_ns.record(trace::now_ns() - ready_ns);
+            ready_ns = 0;
+        }
+
+        //increase score
+        ++score;
+
+        //get rid of opps (and obstacles), number depends on level
+        size_t num_removed = 4;
+        if(!obstacles && !moving_enemies)
+            num_removed = 1;
+        if(obstacles && !moving_enemies)
+            num_removed = 2;
+
+        //newest are removed first, in the reverse order they were blocked
+        for(size_t i = 0; i < num_removed && !vector_oppPositions.empty(); i++)
+        {
+            mark(vector_oppPositions.back().x, vector_oppPositions.back().y);
+            vector_oppPositions.pop_back();
+            reach.unblock_last();
+
+            //if level has obstacles, also remove obstacles
+            if(obstacles)
+            {
+                mark(vector_obstaclePositions.back().x, vector_obstaclePositions.back().y);
+                vector_obstaclePositions.pop_back();
+                reach.unblock_last();
+            }
+        }
+    }
+}
+
+/*
+ * Function to place the green clouds (opponents). Checks if
+ * enough flowers have been collected to draw another opponent.
+ * Gets random coordinates and ensures they don't match coordinates
+ * of other elements, then adds the opponent (and obstacle) to the board.
+ * Squares that would wall off part of the board are never used, so the
+ * bee can always get to the flower and the hive. If the board is too full
+ * for that, nothing is added.
+ */
+void GameEngine::drawOpp()
+{
+    TRACE_SCOPE("drawOpp");
+
+    //if right amount of time has passed, draw a new opp
+    if (counter == 0)
+        return;
+
+    //frequency of opp appearance depends on level (opp_time)
+    if(counter % opp_time != 0)
+        return;
+
+    //give up on a square after this many tries
+    const size_t max_tries = 4*board_size*board_size;
+    size_t tries = 0;
+
+    //opp and obstacle each get their own random numbers
+    CounterRng rng = stream(CounterRng::Opp, opps_placed);
+    CounterRng obstacle_rng = stream(CounterRng::Obstacle, opps_placed);
+    opps_placed++;
+
+    //get random coordinates for opp and obstacle
+    int x = rng.below(board_size);
+    int y = rng.below(board_size);
+    int obstacle_x = obstacle_rng.below(board_size);
+    int obstacle_y = obstacle_rng.below(board_size);
+
+    //if no obstacles then just set obstacle coordinates same as bee
+    if(!obstacles)
+    {
+        obstacle_x = bee_position.x;
+        obstacle_y = bee_position.y;
+    }
+
+    //if level has obstacles, make sure coordinates don't match
+    if(obstacles)
+    {
+        //go through vector of opps and check if coordinates match
+        for(size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
+        {
+            if(obstacle_x == vector_oppPositions[i].x && obstacle_y == vector_oppPositions[i].y)
+            {
+                obstacle_x = obstacle_rng.below(board_size);
+                obstacle_y = obstacle_rng.below(board_size);
+            }
+        }
+
+        //check if obstacle matches coordinates of other objects, or would wall something off
+        while ((obstacle_x == bee_position.x && obstacle_y == bee_position.y) || (obstacle_x == hive_position.x
+        && obstacle_y == hive_position.y) || (obstacle_x == flower_position.x && obstacle_y == flower_position.y)
+               || !reach.can_block(obstacle_x, obstacle_y))
+        {
+            if(++tries > max_tries)
+                return;
+            obstacle_x = obstacle_rng.below(board_size);
+            obstacle_y = obstacle_rng.below(board_size);
+        }
+
+        //opp must leave the board connected with the obstacle in place
+        reach.block(obstacle_x, obstacle_y);
+
+        //go through vector of obstacles and make sure coordinates don't match w/ opp
+        for(size_t i = 0, n = vector_obstaclePositions.size(); i < n; i++)
+        {
+            //if coordinates match, get new coordinates
+            if(x == vector_obstaclePositions[i].x && y == vector_obstaclePositions[i].y)
+            {
+                x = rng.below(board_size);
+                y = rng.below(board_size);
+            }
+        }
+    }
+
+    //make sure coordinates not same as other objects, and don't wall something off
+    tries = 0;
+    while ((x == bee_position.x && y == bee_position.y) || (x == hive_position.x
+    && y == hive_position.y) || (x == flower_position.x && y == flower_position.y)
+           || (x == obstacle_x && y == obstacle_y) || !reach.can_block(x, y))
+    {
+        if(++tries > max_tries)
+        {
+            if(obstacles)
+                reach.unblock_last();
+            return;
+        }
+        x = rng.below(board_size);
+        y = rng.below(board_size);
+    }
+    reach.block(x, y);
+
+    //if level has obstacles, add obstacle
+    if(obstacles)
+    {
+        vector_obstaclePositions.push_back(Cell{obstacle_x, obstacle_y});
+        mark(obstacle_x, obstacle_y);
+    }
+
+    vector_oppPositions.push_back(Cell{x, y});
+    mark(x, y);
+
+    num_opps++;
+}
+
+/*
+ * Function to find what should be drawn in a square. If more than one thing
+ * is in the square, the flower is drawn over obstacles, obstacles over opps,
+ * opps over the hive, the hive over the bee and the bee over the cloud.
+ *
+ * @param x is x coordinate of the square
+ * @param y is y coordinate of the square
+ * @return piece to draw in the square
+ */
+GameEngine::Piece GameEngine::piece_at(int x, int y) const
+{
+    if(x == flower_position.x && y == flower_position.y)
+        return Flower;
+
+    for(size_t i = 0, n = vector_obstaclePositions.size(); i < n; i++)
+    {
+        if(x == vector_obstaclePositions[i].x && y == vector_obstaclePositions[i].y)
+            return Obstacle;
+    }
+
+    for(size_t i = 0, n = vector_oppPositions.size(); i < n; i++)
+    {
+        if(x == vector_oppPositions[i].x && y == vector_oppPositions[i].y)
+            return Opp;
+    }
+
+    if(x == hive_position.x && y == hive_position.y)
+        return Hive;
+
+    if(x == bee_position.x && y == bee_position.y)
+        return Bee;
+
+    for(size_t i = 0, n = vector_cloudPositions.size(); i < n; i++)
+    {
+        if(x == vector_cloudPositions[i].x && y == vector_cloudPositions[i].y)
+            return Cloud;
+    }
+
+    return Empty;
+}
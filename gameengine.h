@@ -0,0 +1,216 @@
+/*
+ * @file gameengine.h
+ * @brief header file to contain GameEngine class declarations
+ *
+ * This headerfile contains the class declaration of the GameEngine class,
+ * which holds the rules of the game (bee, hive, flower, opps, obstacles and
+ * the moving cloud) without any widgets. GameBoard draws whatever state the
+ * engine is in, and the bot server drives the same engine without a window.
+*/
+
+#ifndef GAMEENGINE_H
+#define GAMEENGINE_H
+
+#include "reachability.h"
+#include "counterrng.h"
+#include "enemyscript.h"
+#include "telemetry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * @struct Cell
+ * @brief x and y coordinates of one square on the board
+ */
+struct Cell
+{
+    int x;
+    int y;
+};
+
+/*
+ * @class GameEngine
+ * @brief keeps track of where everything is on the board and applies the
+ * rules when the bee moves or the cloud moves.
+ *
+ * Every random placement comes from its own CounterRng stream, keyed by
+ * the seed, what is being placed, how many of those came before and the
+ * tick. Two engines built with the same settings and seed play exactly
+ * the same game, and no placement depends on the order of the others.
+ */
+class GameEngine
+{
+public:
+    //what can be in a square, in the order it is drawn (later wins)
+    enum Piece { Empty = 0, Cloud, Bee, Hive, Opp, Obstacle, Flower };
+
+    //moves the player can make, same as the arrow keys
+    enum Move { Stay = 0, Left, Right, Up, Down };
+
+    //what set_heat's counts count: squares the bee moved to, flowers
+    //picked, and where games ended
+    enum HeatKind { HeatVisits = 0, HeatFlowers, HeatDeaths, HeatKinds };
+
+    //difficulties on the start menu: easy has no obstacles or moving
+    //enemies, medium has obstacles, hard has both
+    enum Difficulty { Easy = 0, Medium, Hard, Difficulties };
+    static int difficulty(bool moving_enemies, bool obstacles)
+    {
+        if(moving_enemies)
+            return Hard;
+        return obstacles ? Medium : Easy;
+    }
+
+    //everything that changes during a game, used to save and go back to a moment
+    struct Snapshot
+    {
+        Cell bee;
+        Cell flower;
+        std::vector<Cell> opps;
+        std::vector<Cell> obstacles;
+        std::vector<Cell> clouds;
+        std::vector<Cell> cloud_velocities;
+        std::vector<int> cloud_behaviours;
+        std::vector<int32_t> cloud_memory;
+        size_t counter;
+        size_t score;
+        size_t num_opps;
+        int progress;
+        bool over;
+        unsigned seed;
+        uint64_t ticks;
+        uint32_t flowers_placed;
+        uint32_t opps_placed;
+    };
+
+    explicit GameEngine(size_t board_size = 15, int opp_time = 5, bool moving_enemies = true, bool obstacles = true, unsigned seed = 0);
+
+    //start a new game with the same settings
+    void reset(unsigned seed);
+
+    //copy the game out, or go back to a copy (every square is marked changed)
+    void save(Snapshot& s) const;
+    void load(const Snapshot& s);
+
+    //functions that change the board, named after the GameBoard ones
+    bool press(Move m);
+    void moveBee(int prev_x, int prev_y, int next_x, int next_y);
+    void setFlower();
+    void drawOpp();
+    void create_enemy();
+    void add_enemy(int x, int y, int vx, int vy, int behaviour = -1);
+    void move_enemy();
+    void enemy_coordinates(size_t i);
+
+    //scripted enemy behaviours; they last across reset(), like the other settings
+    int add_behaviour(const EnemyScript& script);
+    void set_enemy_behaviour(int behaviour) { enemy_behaviour = behaviour; }
+
+    //counts to add to as the game is played, HeatKinds blocks of one per
+    //square, row by row; 0 for none. They are added to atomically, so other
+    //games (even in other programs) can share them. Not part of a Snapshot
+    void set_heat(std::atomic<uint32_t>* counts) { heat = counts; }
+
+    //where to record flowers, drops at the hive and losses (see telemetry.h),
+    //or 0 for nowhere. Not part of a Snapshot
+    void set_metrics(telemetry::Metrics* m) { metrics = m; }
+
+    //what is in square (x,y), as it should be drawn
+    Piece piece_at(int x, int y) const;
+
+    //squares that changed since the last call to clear_changed()
+    const std::vector<int>& changed_cells() const { return changed; }
+    void clear_changed() { changed.clear(); }
+
+    size_t get_board_size() const { return board_size; }
+    int get_opp_time() const { return opp_time; }
+    bool has_moving_enemies() const { return moving_enemies; }
+    bool has_obstacles() const { return obstacles; }
+    int get_difficulty() const { return difficulty(moving_enemies, obstacles); }
+
+    const Cell& bee() const { return bee_position; }
+    const Cell& hive() const { return hive_position; }
+    const Cell& flower() const { return flower_position; }
+    const std::vector<Cell>& opps() const { return vector_oppPositions; }
+    const std::vector<Cell>& obstacle_cells() const { return vector_obstaclePositions; }
+    const std::vector<Cell>& clouds() const { return vector_cloudPositions; }
+    const std::vector<Cell>& cloud_velocities() const { return vector_cloudVelocities; }
+    const std::vector<int>& cloud_behaviours() const { return vector_cloudBehaviours; }
+
+    size_t get_counter() const { return counter; }
+    size_t get_score() const { return score; }
+    int get_progress() const { return progress; }
+    bool hive_ready() const { return progress == 100; }
+    bool is_over() const { return over; }
+
+private:
+    void set_progress(int value);
+    void mark(int x, int y);
+    void rebuild_reach();
+    bool stops_enemy(int x, int y) const;
+    void run_behaviours();
+    void spawn_enemy(int behaviour);
+    CounterRng stream(CounterRng::Kind kind, uint64_t index) const { return CounterRng(seed, kind, index, ticks); }
+    void add_heat(int kind, int x, int y)
+    {
+        if(heat)
+            heat[(kind*board_size + y)*board_size + x].fetch_add(1, std::memory_order_relaxed);
+    }
+    void note_loss(int x, int y);
+
+    //random placement comes from these (see CounterRng)
+    unsigned seed;
+    uint64_t ticks; //number of times the enemies have moved
+    uint32_t flowers_placed;
+    uint32_t opps_placed; //times drawOpp looked for squares, whether or not it used them
+
+    //positions of characters
+    Cell bee_position;
+    Cell hive_position;
+    Cell flower_position;
+
+    //vectors to store all opp, obstacle and cloud positions
+    std::vector<Cell> vector_oppPositions;
+    std::vector<Cell> vector_obstaclePositions;
+    std::vector<Cell> vector_cloudPositions;
+    std::vector<Cell> vector_cloudVelocities; //squares moved per tick, straight or diagonal
+    std::vector<int> vector_cloudBehaviours; //index into behaviours, -1 to keep its velocity
+    std::vector<int32_t> vector_cloudMemory; //each scripted enemy's mem
+
+    //enemy scripts, the one create_enemy gives new enemies (-1 for none),
+    //and the machine they run on
+    std::vector<EnemyScript> behaviours;
+    int enemy_behaviour;
+    EnemyVm vm;
+    std::vector<uint32_t> lanes; //enemies with the behaviour being run
+
+    std::vector<int> changed; //label numbers that need redrawing
+
+    size_t counter; //number of flowers visited
+    size_t score;
+    size_t num_opps; //number of opponents
+    int progress; //value of progress bar, 0-100
+    bool over; //set once the bee hits an opp or cloud
+
+    //Board variables
+    size_t board_size;
+    int opp_time; //determines difficulty
+
+    bool moving_enemies; //whether there's moving enemy
+    bool obstacles; //whether there are obstacles
+
+    //which squares opps and obstacles block, so they never wall anything off
+    Reachability reach;
+
+    std::atomic<uint32_t>* heat; //see set_heat
+
+    //see set_metrics; when this game's last flower was picked and the
+    //progress bar filled, 0 if it hasn't since the game started or went back
+    telemetry::Metrics* metrics;
+    uint64_t flower_ns;
+    uint64_t ready_ns;
+};
+
+#endif // GAMEENGINE_H
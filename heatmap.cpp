@@ -0,0 +1,173 @@
+/*
+ * @file heatmap.cpp
+ * @brief contains class definition of Heatmap class
+ *
+ * A new file is made the right size with a header and every count 0,
+ * under a lock file next to it, so a game starting at the same time never
+ * sees it half made. A file with a different header (another version, or
+ * damaged) is left alone and the game runs without counting.
+ */
+
+#include "heatmap.h"
+#include <QDir>
+#include <QLockFile>
+#include <QStandardPaths>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static const uint32_t heat_magic = 0x48344857; //"WH4H"
+static const uint32_t heat_version = 1;
+
+//longest to wait for another game to finish making the file
+static const int lock_wait_ms = 5000;
+
+//counts start after the header, 8 words so they are well aligned
+struct HeatHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t board_size;
+    uint32_t difficulties;
+    uint32_t kinds;
+    uint32_t unused[3];
+};
+
+/*
+ * Constructor for the Heatmap class. Opens or makes the file and maps it.
+ * Problems are reported with qWarning and leave the heatmap closed.
+ *
+ * @param board_sz is the size of the board the counts are for
+ * @param path is the file to use, or empty for the usual one
+ */
+Heatmap::Heatmap(size_t board_sz, const QString& path) :
+    board_size(board_sz), data(0)
+{
+    QString name = path;
+    if(name.isEmpty() && std::getenv("HW4B_HEATMAP"))
+        name = QString::fromLocal8Bit(std::getenv("HW4B_HEATMAP"));
+    if(name.isEmpty())
+    {
+        QString folder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(folder);
+        name = folder + QString("/heatmap-%1.bin").arg(board_size);
+    }
+
+    HeatHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = heat_magic;
+    header.version = heat_version;
+    header.board_size = board_size;
+    header.difficulties = GameEngine::Difficulties;
+    header.kinds = GameEngine::HeatKinds;
+    qint64 size = sizeof(header) + qint64(GameEngine::Difficulties)*GameEngine::HeatKinds*board_size*board_size*sizeof(uint32_t);
+
+    //every game opens the file holding this lock, so none can look at it
+    //while another is still making it
+    QLockFile lock(name + ".lock");
+    if(!lock.tryLock(lock_wait_ms))
+    {
+        qWarning("heatmap: can't lock %s", qPrintable(name));
+        return;
+    }
+
+    file.setFileName(name);
+    if(!file.open(QIODevice::ReadWrite))
+    {
+        qWarning("heatmap: can't open %s", qPrintable(name));
+        return;
+    }
+
+    //a new file; growing it fills the counts with zeros
+    if(file.size() == 0)
+    {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.resize(size);
+    }
+
+    HeatHeader found;
+    if(file.size() != size || !file.seek(0) ||
+       file.read(reinterpret_cast<char*>(&found), sizeof(found)) != qint64(sizeof(found)) ||
+       std::memcmp(&found, &header, sizeof(header)) != 0)
+    {
+        qWarning("heatmap: %s is not a heatmap for a %u board", qPrintable(name), unsigned(board_size));
+        file.close();
+        return;
+    }
+
+    data = file.map(0, size);
+    if(!data)
+        qWarning("heatmap: can't map %s", qPrintable(name));
+}
+
+/*
+ * Destructor for Heatmap class. Unmapping lets the system write the last
+ * counts back.
+ */
+Heatmap::~Heatmap()
+{
+    if(data)
+        file.unmap(data);
+}
+
+/*
+ * Function to get the counts of one difficulty, laid out as
+ * GameEngine::set_heat wants them.
+ */
+std::atomic<uint32_t>* Heatmap::counts(int difficulty)
+{
+    if(!data || difficulty < 0 || difficulty >= GameEngine::Difficulties)
+        return 0;
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "counts are plain 32-bit words in the file");
+    size_t offset = sizeof(HeatHeader) + size_t(difficulty)*GameEngine::HeatKinds*board_size*board_size*sizeof(uint32_t);
+    return reinterpret_cast<std::atomic<uint32_t>*>(data + offset);
+}
+
+/*
+ * Function to draw one kind of count. Counts are shown on a log scale, so
+ * a square used a few times still shows next to one used thousands of
+ * times. This looks at every square, so it is for when the overlay is
+ * shown, not for every move.
+ *
+ * @param difficulty is which difficulty's counts to draw
+ * @param kind is a GameEngine::HeatKind
+ * @param color is the colour of the most-counted square
+ * @param out receives the image, board_size pixels square
+ */
+void Heatmap::draw(int difficulty, int kind, const QColor& color, QImage& out) const
+{
+    if(out.width() != int(board_size) || out.height() != int(board_size) || out.format() != QImage::Format_ARGB32_Premultiplied)
+        out = QImage(board_size, board_size, QImage::Format_ARGB32_Premultiplied);
+    out.fill(Qt::transparent);
+
+    std::atomic<uint32_t>* all = const_cast<Heatmap*>(this)->counts(difficulty);
+    if(!all || kind < 0 || kind >= GameEngine::HeatKinds)
+        return;
+
+    size_t n = board_size*board_size;
+    const std::atomic<uint32_t>* c = all + kind*n;
+    uint32_t most = 0;
+    for(size_t i = 0; i < n; i++)
+        most = std::max(most, c[i].load(std::memory_order_relaxed));
+    if(most == 0)
+        return;
+
+    double scale = 1 / std::log(1.0 + most);
+    for(size_t y = 0; y < board_size; y++)
+    {
+        QRgb* row = reinterpret_cast<QRgb*>(out.scanLine(y));
+        for(size_t x = 0; x < board_size; x++)
+        {
+            uint32_t count = c[y*board_size + x].load(std::memory_order_relaxed);
+            if(count == 0)
+                continue;
+
+            //at least a little showing, up to mostly covering the square
+            int alpha = 40 + int(180*std::log(1.0 + count)*scale);
+            row[x] = qPremultiply(qRgba(color.red(), color.green(), color.blue(), alpha));
+        }
+    }
+}
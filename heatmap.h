@@ -0,0 +1,55 @@
+/*
+ * @file heatmap.h
+ * @brief header file to contain Heatmap class declarations
+ *
+ * This headerfile contains the class declaration of the Heatmap class, the
+ * counts of where bees have been, picked flowers and died, kept in a file
+ * that every game on the computer adds to.
+*/
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "gameengine.h"
+#include <QColor>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+/*
+ * @class Heatmap
+ * @brief per-square counts for each difficulty, in a memory-mapped file
+ *
+ * The file is a small header followed by, for each GameEngine::Difficulty,
+ * the GameEngine::HeatKinds blocks of one 32-bit count per square. It is
+ * mapped into memory, so the engine adds to a count with one atomic
+ * increment and never reads or writes the file itself; the system writes
+ * changed pages back when it likes. Games running at the same time map the
+ * same file and add to the same counts. Each board size has its own file.
+ */
+class Heatmap
+{
+public:
+    //maps the counts for board_size from path, or from the file named by
+    //HW4B_HEATMAP or in the app's data folder if path is empty
+    explicit Heatmap(size_t board_size, const QString& path = QString());
+    ~Heatmap();
+
+    bool is_open() const { return data != 0; }
+
+    //difficulty's counts for GameEngine::set_heat, or 0 if the file couldn't be used
+    std::atomic<uint32_t>* counts(int difficulty);
+
+    //draw one kind of count as an image with one pixel per square; the
+    //most-counted square is color, and squares never counted are clear
+    void draw(int difficulty, int kind, const QColor& color, QImage& out) const;
+
+private:
+    size_t board_size;
+    QFile file;
+    uchar* data; //the whole file, mapped
+};
+
+#endif // HEATMAP_H
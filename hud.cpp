@@ -0,0 +1,185 @@
+/*
+ * @file hud.cpp
+ * @brief contains class definition of Hud class
+ *
+ * From left to right: the progress bar with its percentage, the message,
+ * then the score picture and the score. Text is drawn centred up and down
+ * in its part of the strip.
+ */
+
+#include "hud.h"
+#include <QPainter>
+#include <QFontMetrics>
+#include <QPaintEvent>
+#include <QResizeEvent>
+
+//width of the progress bar, same as the old QProgressBar's maximum width
+static const int bar_width = 100;
+static const int gap = 8;
+
+/*
+ * Constructor for the Hud class. Starts with no progress, no message and
+ * a score of 0.
+ *
+ * @param theme gives the colours and fonts
+ * @param score_img is drawn next to the score
+ * @param parent is the widget the header is in
+ */
+Hud::Hud(const Theme& th, const QPixmap& score_img, QWidget *parent) :
+    QWidget(parent), theme(th), score_image(score_img), progress(0), score(0)
+{
+    setAutoFillBackground(true);
+    setPalette(theme.hud);
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+
+    //text never changes size when scaled, so the layouts can be reused as is
+    progress_text.setPerformanceHint(QStaticText::AggressiveCaching);
+    message_text.setPerformanceHint(QStaticText::AggressiveCaching);
+    score_text.setPerformanceHint(QStaticText::AggressiveCaching);
+
+    place();
+    set_text(progress_text, "0%", font(), bar_area);
+    set_text(score_text, "0", theme.score_font, score_area);
+}
+
+/*
+ * Function to find a height that fits the tallest part of the header.
+ */
+QSize Hud::sizeHint() const
+{
+    int h = qMax(score_image.height(), QFontMetrics(theme.score_font).height());
+    h = qMax(h, QFontMetrics(theme.message_font).height());
+    return QSize(500, h + 4);
+}
+
+/*
+ * Function to work out where each part is drawn. The score sits against
+ * the right edge with room for five digits.
+ */
+void Hud::place()
+{
+    int h = height();
+    int bar_height = qMin(h - 4, QFontMetrics(font()).height() + 6);
+    bar_area = QRect(0, (h - bar_height) / 2, bar_width, bar_height);
+
+    QFontMetrics score_metrics(theme.score_font);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    int score_width = score_metrics.horizontalAdvance("99999");
+#else
+    int score_width = score_metrics.width("99999");
+#endif
+    score_area = QRect(width() - score_width, 0, score_width, h);
+
+    QSize img = score_image.size();
+    score_image_area = QRect(score_area.left() - gap - img.width(), (h - img.height()) / 2, img.width(), img.height());
+
+    int left = bar_area.right() + 1 + gap;
+    message_area = QRect(left, 0, qMax(0, score_image_area.left() - gap - left), h);
+}
+
+void Hud::resizeEvent(QResizeEvent *e)
+{
+    Q_UNUSED(e);
+    place();
+}
+
+/*
+ * Function to lay out a piece of text again and redraw where it goes.
+ */
+void Hud::set_text(QStaticText& text, const QString& value, const QFont& f, const QRect& area)
+{
+    text.setText(value);
+    text.prepare(QTransform(), f);
+    update(area);
+}
+
+/*
+ * Function to set how full the progress bar is. Values outside 0-100 are
+ * ignored, like QProgressBar does.
+ *
+ * @param value is how full the bar is, 0-100
+ */
+void Hud::set_progress(int value)
+{
+    if(value == progress || value < 0 || value > 100)
+        return;
+
+    progress = value;
+    set_text(progress_text, QString::number(value) + "%", font(), bar_area);
+}
+
+/*
+ * Function to set the message next to the progress bar.
+ *
+ * @param text is the message, empty for none
+ */
+void Hud::set_message(const QString& text)
+{
+    if(text == message)
+        return;
+
+    message = text;
+    set_text(message_text, text, theme.message_font, message_area);
+}
+
+/*
+ * Function to set the score shown at the right.
+ *
+ * @param value is the score
+ */
+void Hud::set_score(size_t value)
+{
+    if(value == score)
+        return;
+
+    score = value;
+    set_text(score_text, QString::number(value), theme.score_font, score_area);
+}
+
+/*
+ * Function to draw the header. Only the parts that were asked to be
+ * redrawn are drawn.
+ */
+void Hud::paintEvent(QPaintEvent *e)
+{
+    QPainter painter(this);
+    const QRect& dirty = e->rect();
+
+    if(dirty.intersects(bar_area))
+    {
+        QRect inside = bar_area.adjusted(0, 0, -1, -1);
+        painter.setPen(theme.bar_border);
+        painter.setBrush(theme.bar_background);
+        painter.drawRect(inside);
+
+        QRect filled = inside.adjusted(1, 1, 0, 0);
+        filled.setWidth(filled.width() * progress / 100);
+        painter.fillRect(filled, theme.bar_color);
+
+        QSizeF size = progress_text.size();
+        painter.setFont(font());
+        painter.setPen(palette().color(QPalette::WindowText));
+        painter.drawStaticText(QPointF(bar_area.center().x() - size.width() / 2,
+                                       bar_area.center().y() - size.height() / 2), progress_text);
+    }
+
+    if(dirty.intersects(message_area) && !message.isEmpty())
+    {
+        painter.setClipRect(message_area);
+        painter.setFont(theme.message_font);
+        painter.setPen(theme.message_color);
+        painter.drawStaticText(QPointF(message_area.left(), (height() - message_text.size().height()) / 2), message_text);
+        painter.setClipping(false);
+    }
+
+    if(dirty.intersects(score_image_area))
+        painter.drawPixmap(score_image_area.topLeft(), score_image);
+
+    if(dirty.intersects(score_area))
+    {
+        QSizeF size = score_text.size();
+        painter.setFont(theme.score_font);
+        painter.setPen(palette().color(QPalette::WindowText));
+        painter.drawStaticText(QPointF(score_area.left(), (height() - size.height()) / 2), score_text);
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * @file hud.h
+ * @brief header file to contain Hud class declarations
+ *
+ * This headerfile contains the class declaration of the Hud class, the
+ * strip above the board with the progress bar, the message and the score.
+*/
+
+#ifndef HUD_H
+#define HUD_H
+
+#include "theme.h"
+#include <QWidget>
+#include <QPixmap>
+#include <QStaticText>
+#include <QString>
+
+/*
+ * @class Hud
+ * @brief draws the progress bar, message and score
+ *
+ * Each piece of text is kept as a QStaticText, which is laid out once and
+ * then drawn again without working out the glyphs. Text is only laid out
+ * again, and only its part of the widget redrawn, when its value changes,
+ * so setting the same progress or score every key press costs nothing.
+ */
+class Hud : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Hud(const Theme& theme, const QPixmap& score_image, QWidget *parent = 0);
+
+    void set_progress(int value);
+    void set_message(const QString& text);
+    void set_score(size_t value);
+
+    QSize sizeHint() const;
+    void paintEvent(QPaintEvent *e);
+    void resizeEvent(QResizeEvent *e);
+
+private:
+    void place();
+    void set_text(QStaticText& text, const QString& value, const QFont& font, const QRect& area);
+
+    const Theme& theme;
+    QPixmap score_image;
+
+    int progress;
+    QString message;
+    size_t score;
+
+    QStaticText progress_text;
+    QStaticText message_text;
+    QStaticText score_text;
+
+    //where each part is drawn, worked out when the widget changes size
+    QRect bar_area;
+    QRect message_area;
+    QRect score_image_area;
+    QRect score_area;
+};
+
+#endif // HUD_H
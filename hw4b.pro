@@ -12,15 +12,60 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = hw4b
 TEMPLATE = app
 
+CONFIG += c++11
+
 
 SOURCES += main.cpp\
         mainwindow.cpp \
     gameboard.cpp \
-    instructions.cpp
+    instructions.cpp \
+    gameengine.cpp \
+    enemyscript.cpp \
+    spritelayer.cpp \
+    spriteatlas.cpp \
+    trace.cpp \
+    telemetry.cpp \
+    rewind.cpp \
+    reachability.cpp \
+    planner.cpp \
+    swarm.cpp \
+    heatmap.cpp \
+    inputstress.cpp \
+    theme.cpp \
+    hud.cpp \
+    simulation.cpp \
+    framerenderer.cpp \
+    boardview.cpp \
+    minimap.cpp
+
+unix: SOURCES += botserver.cpp
+unix: LIBS += -lpthread
 
 HEADERS  += mainwindow.h \
     gameboard.h \
-    instructions.h
+    instructions.h \
+    gameengine.h \
+    counterrng.h \
+    enemyscript.h \
+    spritelayer.h \
+    spriteatlas.h \
+    trace.h \
+    telemetry.h \
+    rewind.h \
+    reachability.h \
+    planner.h \
+    swarm.h \
+    heatmap.h \
+    inputstress.h \
+    theme.h \
+    hud.h \
+    simulation.h \
+    spscqueue.h \
+    triplebuffer.h \
+    framerenderer.h \
+    boardview.h \
+    minimap.h \
+    botserver.h
 
 FORMS    += mainwindow.ui \
     gameboard.ui \
@@ -28,3 +73,31 @@ FORMS    += mainwindow.ui \
 
 RESOURCES += \
     images.qrc
+
+
+# board sprites are decoded and scaled at build time by tools/spritepack
+# and compiled in as spriteatlas_data.cpp (see spriteatlas.h). 50 is what
+# GameBoard asks for (BoardView scales it to the zoom); 33 is FrameRenderer's
+# square on the 15x15 board --export-frames plays.
+SPRITE_SIZES = 33,50
+SPRITE_IMAGES = bee hive flower cloud child factory
+SPRITE_FILES = bee.jpg hive.jpg flower.png cloud.png child.jpg factory.png
+
+for(i, 0..5) {
+    SPRITE_ARGS += $$member(SPRITE_IMAGES, $$i)=$$PWD/$$member(SPRITE_FILES, $$i)
+    SPRITE_DEPS += $$PWD/$$member(SPRITE_FILES, $$i)
+}
+SPRITE_ARGS += score=$$PWD/score.png:native
+SPRITE_DEPS += $$PWD/score.png
+
+spritepack.target = spritepack/spritepack
+spritepack.commands = $(MKDIR) spritepack && cd spritepack && $$QMAKE_QMAKE $$PWD/tools/spritepack/spritepack.pro && $(MAKE)
+spritepack.depends = $$PWD/tools/spritepack/main.cpp $$PWD/spriteatlas.h
+
+spriteatlas.target = spriteatlas_data.cpp
+spriteatlas.commands = spritepack/spritepack spriteatlas_data.cpp $$SPRITE_SIZES $$SPRITE_ARGS
+spriteatlas.depends = spritepack/spritepack $$SPRITE_DEPS
+
+QMAKE_EXTRA_TARGETS += spritepack spriteatlas
+GENERATED_SOURCES += spriteatlas_data.cpp
+QMAKE_CLEAN += spriteatlas_data.cpp
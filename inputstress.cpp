@@ -0,0 +1,168 @@
+/*
+ * @file inputstress.cpp
+ * @brief contains class definition of InputStress class
+ *
+ * A 1ms timer sends however many presses are due by now, so the rate is
+ * kept up even when the timer fires late, and a stall is followed by the
+ * burst of presses a real backlog of key events would be.
+ */
+
+#include "inputstress.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QKeyEvent>
+#include <QStringList>
+#include <QtGlobal>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+//most presses sent at once after a stall, so the loop still comes back now and then
+static const uint64_t max_burst = 1000;
+
+//memory is looked at this often, in ns
+static const qint64 memory_every_ns = 100000000;
+
+/*
+ * Constructor for the InputStress class. Starts pressing keys once the
+ * event loop is running.
+ *
+ * @param t is the widget to send key presses to
+ * @param s is the simulation the widget sends commands to
+ * @param settings is "rate,seconds" or "rate,seconds,keys"
+ */
+InputStress::InputStress(QWidget* t, Simulation* s, const QString& settings) :
+    QObject(t), target(t), sim(s), rate(1000), seconds(10),
+    random(0, CounterRng::Input, 0, 0),
+    pressed(0), last_fire_ns(0), longest_gap_ns(0), stalls(0), longest_press_ns(0),
+    memory_checked_ns(0)
+{
+    QStringList parts = settings.split(',');
+    if(parts.size() > 0 && parts[0].toInt() > 0)
+        rate = parts[0].toInt();
+    if(parts.size() > 1 && parts[1].toInt() > 0)
+        seconds = parts[1].toInt();
+    if(parts.size() > 2)
+        keys = parts[2].toUpper();
+
+    start_memory = most_memory = resident_bytes();
+
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(1);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(press_due()));
+    timer.start();
+    clock.start();
+}
+
+/*
+ * Function to find how much memory the program is using, from
+ * /proc/self/statm; 0 where there is no such file.
+ */
+qint64 InputStress::resident_bytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if(!statm.open(QIODevice::ReadOnly))
+        return 0;
+
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if(fields.size() < 2)
+        return 0;
+    return fields[1].toLongLong()*sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Function to pick the next key: [ if the game is over, otherwise the next
+ * letter of the script, or a random arrow if there is no script.
+ */
+int InputStress::next_key()
+{
+    if(sim->frame().over)
+        return Qt::Key_BracketLeft;
+
+    static const int arrows[] = { Qt::Key_Left, Qt::Key_Right, Qt::Key_Up, Qt::Key_Down };
+    if(keys.isEmpty())
+        return arrows[random.below(4)];
+
+    switch(keys[int(pressed % keys.size())].toLatin1())
+    {
+    case 'L': return Qt::Key_Left;
+    case 'R': return Qt::Key_Right;
+    case 'U': return Qt::Key_Up;
+    case 'D': return Qt::Key_Down;
+    case 'H': return Qt::Key_H;
+    case '[': return Qt::Key_BracketLeft;
+    case ']': return Qt::Key_BracketRight;
+    default: return arrows[random.below(4)];
+    }
+}
+
+/*
+ * Function run by the timer. Notes how long the event loop was away, sends
+ * the presses due since the start, and stops when the time is up.
+ */
+void InputStress::press_due()
+{
+    qint64 now = clock.nsecsElapsed();
+    if(last_fire_ns > 0)
+    {
+        qint64 gap = now - last_fire_ns;
+        longest_gap_ns = std::max(longest_gap_ns, gap);
+        if(gap >= qint64(stall_ms)*1000000)
+            stalls++;
+    }
+    last_fire_ns = now;
+
+    if(now - memory_checked_ns >= memory_every_ns)
+    {
+        most_memory = std::max(most_memory, resident_bytes());
+        memory_checked_ns = now;
+    }
+
+    if(now >= qint64(seconds)*1000000000)
+    {
+        //give the simulation a moment to take the last commands and send a frame
+        timer.stop();
+        QTimer::singleShot(500, this, SLOT(report()));
+        return;
+    }
+
+    uint64_t due = uint64_t(now / 1000)*rate / 1000000;
+    for(uint64_t n = 0; pressed < due && n < max_burst; n++)
+    {
+        QKeyEvent press(QEvent::KeyPress, next_key(), Qt::NoModifier);
+        qint64 before = clock.nsecsElapsed();
+        QCoreApplication::sendEvent(target, &press);
+        longest_press_ns = std::max(longest_press_ns, clock.nsecsElapsed() - before);
+        pressed++;
+    }
+}
+
+/*
+ * Function to print what happened and quit. Commands are lost if they were
+ * neither dropped by send() nor taken by the simulation thread.
+ */
+void InputStress::report()
+{
+    const Simulation::Frame& f = sim->frame();
+    uint64_t lost = sim->sent() - sim->dropped() - f.commands_taken;
+    most_memory = std::max(most_memory, resident_bytes());
+
+    qWarning("stress: %llu presses in %d s (asked for %d a second), %llu commands sent",
+             (unsigned long long)pressed, seconds, rate, (unsigned long long)sim->sent());
+    qWarning("stress: %llu dropped, %llu out of order, %llu lost",
+             (unsigned long long)sim->dropped(), (unsigned long long)f.commands_out_of_order, (unsigned long long)lost);
+    qWarning("stress: %d stalls of %d ms or more, longest gap %.1f ms, longest press %.3f ms",
+             stalls, stall_ms, longest_gap_ns / 1e6, longest_press_ns / 1e6);
+    qWarning("stress: memory grew %lld kB (%lld kB to %lld kB)",
+             (long long)(most_memory - start_memory) / 1024, (long long)start_memory / 1024, (long long)most_memory / 1024);
+
+    bool failed = lost != 0 || f.commands_out_of_order != 0 || stalls != 0;
+    qWarning("stress: %s", failed ? "FAILED" : "passed");
+    QCoreApplication::exit(failed ? 1 : 0);
+}
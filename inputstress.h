@@ -0,0 +1,80 @@
+/*
+ * @file inputstress.h
+ * @brief header file to contain InputStress class declarations
+ *
+ * This headerfile contains the class declaration of the InputStress class,
+ * which presses keys on a GameBoard much faster than a person can, to find
+ * out whether the board and the simulation keep up.
+*/
+
+#ifndef INPUTSTRESS_H
+#define INPUTSTRESS_H
+
+#include "counterrng.h"
+#include "simulation.h"
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QWidget>
+#include <cstdint>
+
+/*
+ * @class InputStress
+ * @brief sends key presses to a widget at a set rate and reports how it
+ * coped
+ *
+ * Keys are sent through the event system, so they reach keyPressEvent the
+ * same way real ones do. They come from a script of key letters, repeated,
+ * or at random from the arrow keys. A game that is over is stepped back
+ * with [ so the arrow keys carry it on.
+ *
+ * While it runs it records:
+ *  - key presses made, and commands the simulation dropped or took out of
+ *    order, or never took at all
+ *  - stalls: times the event loop didn't come back for stall_ms or more
+ *  - the longest time a single key press took to handle
+ *  - how much the program's memory grew.
+ * At the end it prints a report and quits the program, with exit code 1 if
+ * any command was lost or out of order or the event loop stalled.
+ */
+class InputStress : public QObject
+{
+    Q_OBJECT
+
+public:
+    //settings are "rate,seconds" or "rate,seconds,keys", where keys are
+    //letters L R U D (arrows), H (hint), [ and ]
+    InputStress(QWidget* target, Simulation* sim, const QString& settings);
+
+    static const int stall_ms = 100; //a whole enemy tick
+
+private slots:
+    void press_due();
+    void report();
+
+private:
+    int next_key();
+    static qint64 resident_bytes();
+
+    QWidget* target;
+    Simulation* sim;
+    int rate; //key presses per second
+    int seconds;
+    QString keys;
+
+    QTimer timer;
+    QElapsedTimer clock;
+    CounterRng random;
+
+    uint64_t pressed;
+    qint64 last_fire_ns; //when press_due last ran
+    qint64 longest_gap_ns;
+    int stalls;
+    qint64 longest_press_ns;
+    qint64 start_memory;
+    qint64 most_memory;
+    qint64 memory_checked_ns;
+};
+
+#endif // INPUTSTRESS_H
@@ -6,8 +6,11 @@
  * @mainpage
  *
  * HW5
- * This file contains the main code to run the program.
- * Unaltered from the version supplied by Qt.
+ * This file contains the main code to run the program. Besides opening the
+ * main window it starts tracing (HW4B_TRACE) and metrics (HW4B_METRICS) when
+ * asked, runs the bot server (--bot-server) or the frame export
+ * (--export-frames) instead of the window, and starts the key-press stress
+ * test (HW4B_STRESS).
  */
 
 
@@ -15,12 +18,48 @@
 #include <QApplication>
 #include <QLabel>
 #include <QWidget>
+#include <cstring>
+#include <cstdlib>
+#include "trace.h"
+#include "telemetry.h"
+#include "framerenderer.h"
+
+#ifdef Q_OS_UNIX
+#include "botserver.h"
+#endif
 
 int main(int argc, char *argv[])
 {   
+    //HW4B_TRACE=<file> records a trace, written at exit or when F9 is pressed;
+    //started first so the bot server's engines can be traced too
+    if(std::getenv("HW4B_TRACE"))
+        trace::start(std::getenv("HW4B_TRACE"));
+
+#ifdef Q_OS_UNIX
+    //hw4b --bot-server <socket> plays for bots without opening a window
+    if(argc == 3 && std::strcmp(argv[1], "--bot-server") == 0)
+        return run_bot_server(argv[2]);
+#endif
+
+    //HW4B_METRICS=<file> keeps gameplay metrics, written to the file every 15s
+    //and at exit; only for people playing, so bots' games don't count
+    if(std::getenv("HW4B_METRICS"))
+        telemetry::start(std::getenv("HW4B_METRICS"), 15);
+
     QApplication a(argc, argv);
+
+    //hw4b --export-frames <image> [ticks] saves a game's ticks as one image
+    //and quits; add -platform offscreen to run it without a display
+    if(argc >= 3 && std::strcmp(argv[1], "--export-frames") == 0)
+        return run_frame_export(argv[2], argc > 3 ? std::atoi(argv[3]) : 100);
+
     MainWindow w;
     w.show();
 
+    //HW4B_STRESS=<rate>,<seconds>[,<keys>] goes straight to a hard game and
+    //presses keys on it, then quits with 1 if it fell behind
+    if(std::getenv("HW4B_STRESS"))
+        w.hard_game_begin();
+
     return a.exec();
 }
@@ -10,6 +10,7 @@
 #include "gameboard.h"
 #include "ui_mainwindow.h"
 #include "instructions.h"
+#include "trace.h"
 #include <QWidget>
 #include <QLabel>
 #include <QVBoxLayout>
@@ -68,6 +69,8 @@ void MainWindow::hard_game_begin()
 */
 void MainWindow::game_over()
 {
+    TRACE_SCOPE("game_over");
+
     //make exit window the main widget
     QWidget* exit = new QWidget;
     exit->setParent(nullptr);
@@ -81,7 +84,7 @@ void MainWindow::game_over()
 
     //add score to end screen
     QString msg = "Score: ";
-    msg += QString::number(board->score);
+    msg += QString::number(board->get_score());
     QLabel* score_message = new QLabel;
     score_message->setText(msg);
     score_message->setFont(endFont);
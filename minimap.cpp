@@ -0,0 +1,139 @@
+/*
+ * @file minimap.cpp
+ * @brief contains class definition of Minimap class
+ *
+ * The minimap sits in the bottom right corner of the board it shows. A
+ * square of the board is size / board_size minimap pixels.
+ */
+
+#include "minimap.h"
+#include "theme.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+
+//gap between the minimap and the corner of the board
+static const int margin = 8;
+
+/*
+ * Constructor for the Minimap class. Picks the pyramid level to draw and
+ * follows the board's changes.
+ *
+ * @param b is the board to show
+ * @param size is the width and height of the minimap in pixels
+ */
+Minimap::Minimap(BoardView *b, int size) :
+    QWidget(b), board(b), level(0)
+{
+    setFixedSize(size, size);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setCursor(Qt::PointingHandCursor);
+
+    while(level + 1 < board->levels() && board->level(level).width() > size)
+        level++;
+
+    connect(board, SIGNAL(squares_changed(QRect)), this, SLOT(squares_changed(QRect)));
+    connect(board, SIGNAL(view_changed(QPointF,qreal)), this, SLOT(view_changed(QPointF,qreal)));
+
+    place();
+    hide();
+}
+
+/*
+ * Function to put the minimap in the board's bottom right corner, in front
+ * of everything else on the board.
+ */
+void Minimap::place()
+{
+    move(board->width() - width() - margin, board->height() - height() - margin);
+    raise();
+}
+
+/*
+ * Function to find the part of the board in view, in squares.
+ */
+QRectF Minimap::shown_squares() const
+{
+    qreal side = board->square_side();
+    return QRectF(-board->view_origin() / side, QSizeF(board->width(), board->height()) / side);
+}
+
+/*
+ * Function to find the minimap pixels covering some squares.
+ */
+QRect Minimap::to_minimap(const QRectF& squares) const
+{
+    qreal scale = qreal(width()) / board->get_board_size();
+    return QRectF(squares.topLeft()*scale, squares.size()*scale).toAlignedRect();
+}
+
+/*
+ * Function to redraw the part of the minimap over squares that changed.
+ *
+ * @param squares is the box round the changed squares
+ */
+void Minimap::squares_changed(QRect squares)
+{
+    if(isVisible())
+        update(to_minimap(QRectF(squares)).adjusted(-1, -1, 1, 1));
+}
+
+/*
+ * Function to move the box round the part in view. Only where the box was
+ * and where it is now are redrawn. The minimap is hidden when the whole
+ * board is in view.
+ */
+void Minimap::view_changed(QPointF origin, qreal side)
+{
+    Q_UNUSED(origin);
+    Q_UNUSED(side);
+
+    place();
+
+    QRectF whole(0, 0, board->get_board_size(), board->get_board_size());
+    bool zoomed = !shown_squares().contains(whole);
+    if(zoomed != isVisible())
+        setVisible(zoomed);
+
+    QRect box = to_minimap(shown_squares().intersected(whole));
+    if(box == viewbox)
+        return;
+    update(viewbox.adjusted(-1, -1, 1, 1));
+    viewbox = box;
+    update(viewbox.adjusted(-1, -1, 1, 1));
+}
+
+/*
+ * Function to draw the board, stretched without smoothing, then the box.
+ *
+ * @param e is QPaintEvent object called
+ */
+void Minimap::paintEvent(QPaintEvent *e)
+{
+    QPainter painter(this);
+    painter.setClipRect(e->rect());
+
+    const QImage& image = board->level(level);
+    qreal scale = qreal(width()) / board->get_board_size();
+    qreal block = scale*(1 << level);
+    painter.drawImage(QRectF(0, 0, image.width()*block, image.height()*block), image);
+
+    painter.setPen(Theme::standard().minimap_view);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(viewbox.adjusted(0, 0, -1, -1));
+}
+
+/*
+ * Functions to move the view to where the minimap is clicked or dragged.
+ */
+void Minimap::mousePressEvent(QMouseEvent *e)
+{
+    qreal scale = qreal(width()) / board->get_board_size();
+    board->look_at(QPointF(e->pos()) / scale);
+}
+
+void Minimap::mouseMoveEvent(QMouseEvent *e)
+{
+    if(e->buttons() & Qt::LeftButton)
+        mousePressEvent(e);
+}
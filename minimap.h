@@ -0,0 +1,53 @@
+/*
+ * @file minimap.h
+ * @brief header file to contain Minimap class declarations
+ *
+ * This headerfile contains the class declaration of the Minimap class, a
+ * small picture of the whole board in the corner of a zoomed in BoardView,
+ * with a box round the part being shown. Clicking or dragging on it moves
+ * the view there.
+*/
+
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "boardview.h"
+#include <QWidget>
+#include <QRectF>
+
+/*
+ * @class Minimap
+ * @brief draws one level of a BoardView's pyramid
+ *
+ * The level used is the biggest one no wider than the minimap, so drawing
+ * it is a small stretch. The pyramid is already kept up to date square by
+ * square, so when squares change only the minimap pixels covering them are
+ * drawn again. It hides itself while the whole board is in view.
+ */
+class Minimap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Minimap(BoardView *board, int size = 120);
+
+public slots:
+    void squares_changed(QRect squares);
+    void view_changed(QPointF origin, qreal side);
+
+protected:
+    void paintEvent(QPaintEvent *e);
+    void mousePressEvent(QMouseEvent *e);
+    void mouseMoveEvent(QMouseEvent *e);
+
+private:
+    QRectF shown_squares() const;
+    QRect to_minimap(const QRectF& squares) const;
+    void place();
+
+    BoardView* board;
+    int level;
+    QRect viewbox; //box round the part of the board in view, as last drawn
+};
+
+#endif // MINIMAP_H
@@ -0,0 +1,472 @@
+/*
+ * @file planner.cpp
+ * @brief contains class definition of Planner class
+ *
+ * The search keeps a State for each ply and copies it into the next one
+ * before changing it; the copies reuse their memory, so searching doesn't
+ * allocate once the first search has been done. The rules here are
+ * GameEngine's, cut down to what a few moves ahead can show.
+ */
+
+#include "planner.h"
+#include "counterrng.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdlib>
+
+//places tried for new flowers (and opps) at a chance node
+static const int chance_samples = 3;
+
+//deepest search tried, however much time there is
+static const int max_depth = 64;
+
+//value of losing, well below anything else
+static const double lost = -100000;
+
+//how much a position's value is its best move's value, rather than how it
+//looks now; under 1 so getting somewhere good sooner is worth more
+static const double carry = 0.95;
+
+//things the hash has keys for
+enum KeyKind { BeeKey = 1, FlowerKey, EnemyKey, OppKey, WallKey, CountsKey };
+
+/*
+ * Constructor for the Planner class.
+ *
+ * @param table_bits sets the size of the transposition table
+ */
+Planner::Planner(int table_bits) :
+    board_size(0), opp_time(1), obstacles(false), salt(0),
+    table(size_t(1) << table_bits), mask((uint64_t(1) << table_bits) - 1), nodes(0), stopped(false)
+{
+    hive = Cell{0, 0};
+    states.resize(max_depth + 2);
+    before_chance.resize(max_depth + 2);
+}
+
+/*
+ * Function to get the Zobrist key of one thing on one square (or one
+ * value of a count).
+ */
+uint64_t Planner::key(int kind, int64_t what) const
+{
+    return CounterRng::mix(salt ^ (uint64_t(kind) << 56) ^ uint64_t(what));
+}
+
+//the counts share a key, as they change together
+uint64_t Planner::counts_key(const State& s) const
+{
+    return key(CountsKey, (int64_t(s.score) << 16) ^ (int64_t(s.counter) << 8) ^ s.progress);
+}
+
+uint64_t Planner::enemy_key(const Enemy& e) const
+{
+    int64_t square = int64_t(e.y)*board_size + e.x;
+    int64_t velocity = ((e.dx + 1)*3 + e.dy + 1)*64 + std::min(e.speed, 63);
+    return key(EnemyKey, square*1024 + velocity);
+}
+
+bool Planner::is_opp(int x, int y) const
+{
+    int64_t square = int64_t(y)*board_size + x;
+    return std::binary_search(opps.begin(), opps.end(), square)
+            || std::find(added_opps.begin(), added_opps.end(), square) != added_opps.end();
+}
+
+bool Planner::is_obstacle(int x, int y) const
+{
+    int64_t square = int64_t(y)*board_size + x;
+    return std::binary_search(walls.begin(), walls.end(), square)
+            || std::find(added_walls.begin(), added_walls.end(), square) != added_walls.end();
+}
+
+/*
+ * Function to check if an enemy can't move into a square, as
+ * GameEngine::stops_enemy does.
+ */
+bool Planner::stops_enemy(const State& s, int x, int y) const
+{
+    if(x < 0 || y < 0 || x >= board_size || y >= board_size)
+        return true;
+    return (x == s.flower.x && y == s.flower.y) || (x == hive.x && y == hive.y) || is_opp(x, y)
+            || is_obstacle(x, y);
+}
+
+/*
+ * Function to check if a flower, opp or obstacle could appear on a square.
+ */
+bool Planner::free_for_spawn(const State& s, int x, int y) const
+{
+    return !(x == s.bee.x && y == s.bee.y) && !(x == hive.x && y == hive.y) && !is_opp(x, y) && !is_obstacle(x, y);
+}
+
+/*
+ * Function to find the best move from the engine's state.
+ *
+ * @param engine is the game
+ * @param budget_us is about how long to search, in microseconds
+ * @return the move, and how deep the search got
+ */
+Planner::Result Planner::plan(const GameEngine& engine, int budget_us)
+{
+    TRACE_SCOPE("Planner::plan");
+
+    deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget_us);
+    stopped = false;
+    nodes = 0;
+
+    board_size = engine.get_board_size();
+    opp_time = engine.get_opp_time();
+    obstacles = engine.has_obstacles();
+    hive = engine.hive();
+    salt = CounterRng::mix(uint64_t(board_size) << 32 ^ uint64_t(opp_time) << 1 ^ uint64_t(obstacles));
+
+    //opps and obstacles that are already there are part of the hash too, so
+    //the table can be kept from one call to the next
+    State& root = states[0];
+    root.hash = 0;
+    opps.clear();
+    for(size_t i = 0; i < engine.opps().size(); i++)
+    {
+        opps.push_back(int64_t(engine.opps()[i].y)*board_size + engine.opps()[i].x);
+        root.hash ^= key(OppKey, opps.back());
+    }
+    walls.clear();
+    for(size_t i = 0; i < engine.obstacle_cells().size(); i++)
+    {
+        walls.push_back(int64_t(engine.obstacle_cells()[i].y)*board_size + engine.obstacle_cells()[i].x);
+        root.hash ^= key(WallKey, walls.back());
+    }
+    std::sort(opps.begin(), opps.end());
+    std::sort(walls.begin(), walls.end());
+    added_opps.clear();
+    added_walls.clear();
+
+    root.bee = engine.bee();
+    root.flower = engine.flower();
+    root.counter = engine.get_counter();
+    root.progress = engine.get_progress();
+    root.score = engine.get_score();
+    root.over = engine.is_over();
+    root.enemies.clear();
+    for(size_t i = 0; i < engine.clouds().size(); i++)
+    {
+        const Cell& c = engine.clouds()[i];
+        const Cell& v = engine.cloud_velocities()[i];
+        Enemy e = { c.x, c.y, (v.x > 0) - (v.x < 0), (v.y > 0) - (v.y < 0), std::max(std::abs(v.x), std::abs(v.y)) };
+        if(e.speed == 0)
+            continue;
+        root.enemies.push_back(e);
+        root.hash ^= enemy_key(e);
+    }
+    root.hash ^= key(BeeKey, int64_t(root.bee.y)*board_size + root.bee.x);
+    root.hash ^= key(FlowerKey, int64_t(root.flower.y)*board_size + root.flower.x);
+    root.hash ^= counts_key(root);
+
+    Result best = { GameEngine::Stay, 0, 0, 0 };
+    if(root.over)
+        return best;
+
+    //one step deeper each time, keeping the last answer that finished
+    for(int depth = 1; depth <= max_depth; depth++)
+    {
+        double best_value = lost - 1;
+        int best_move = GameEngine::Stay;
+
+        for(int m = GameEngine::Stay; m <= GameEngine::Down && !stopped; m++)
+        {
+            State& next = states[1];
+            next = root;
+            if(m != GameEngine::Stay && !move_bee(next, m))
+                continue;
+
+            double value = after_move(1, depth - 1);
+            if(!stopped && value > best_value)
+            {
+                best_value = value;
+                best_move = m;
+            }
+        }
+
+        if(stopped)
+            break;
+
+        best.move = static_cast<GameEngine::Move>(best_move);
+        best.depth = depth;
+        best.value = best_value;
+    }
+
+    best.nodes = nodes;
+    return best;
+}
+
+/*
+ * Function to check the clock, every so many positions.
+ */
+bool Planner::out_of_time()
+{
+    if(!stopped && (nodes & 255) == 0 && std::chrono::steady_clock::now() >= deadline)
+        stopped = true;
+    return stopped;
+}
+
+/*
+ * Function to finish a step whose bee move has been made in states[ply]:
+ * new flowers if one was picked, then the enemies move.
+ *
+ * @return the value of the step, averaged over new flower places
+ */
+double Planner::after_move(int ply, int depth)
+{
+    State& s = states[ply];
+    if(s.over)
+        return lost + ply;
+
+    //the flower is only ever on the bee's square just after it was picked
+    bool picked = s.bee.x == s.flower.x && s.bee.y == s.flower.y;
+    if(!picked)
+    {
+        move_enemies(s);
+        return search(ply, depth);
+    }
+
+    double total = 0;
+    size_t opps_before = added_opps.size();
+    size_t walls_before = added_walls.size();
+    before_chance[ply] = s;
+    for(int sample = 0; sample < chance_samples && !stopped; sample++)
+    {
+        State& after = states[ply];
+        after = before_chance[ply];
+        place_spawns(after, sample);
+        move_enemies(after);
+        total += search(ply, depth);
+
+        added_opps.resize(opps_before);
+        added_walls.resize(walls_before);
+    }
+    return total / chance_samples;
+}
+
+/*
+ * Function to find the value of the position in states[ply], whose bee
+ * is about to move, searching depth more steps.
+ */
+double Planner::search(int ply, int depth)
+{
+    const State& s = states[ply];
+    nodes++;
+    if(s.over)
+        return lost + ply;
+    if(out_of_time() || depth == 0 || ply >= max_depth)
+        return evaluate(s);
+
+    Entry& entry = table[s.hash & mask];
+    if(entry.used && entry.key == s.hash && entry.depth >= depth)
+        return entry.value;
+
+    double best_value = lost - 1;
+    int best_move = GameEngine::Stay;
+    for(int m = GameEngine::Stay; m <= GameEngine::Down; m++)
+    {
+        State& next = states[ply + 1];
+        next = states[ply];
+        if(m != GameEngine::Stay && !move_bee(next, m))
+            continue;
+
+        double value = after_move(ply + 1, depth - 1);
+        if(value > best_value)
+        {
+            best_value = value;
+            best_move = m;
+        }
+    }
+
+    //a position is worth a little of how it looks now as well as what comes
+    //after, so a move that gets to the same place later (like waiting when
+    //nothing else moves) is worth less than one that gets there now
+    best_value = (1 - carry)*evaluate(states[ply]) + carry*best_value;
+
+    //a search cut short by the clock isn't worth keeping
+    if(!stopped)
+    {
+        Entry& e = table[states[ply].hash & mask];
+        if(!e.used || e.key == states[ply].hash || e.depth <= depth)
+        {
+            e.key = states[ply].hash;
+            e.value = best_value;
+            e.depth = depth;
+            e.move = best_move;
+            e.used = 1;
+        }
+    }
+    return best_value;
+}
+
+/*
+ * Function to move the bee, as GameEngine::moveBee does.
+ *
+ * @return false if the move does nothing (off the edge or into an
+ * obstacle), so it is the same as staying
+ */
+bool Planner::move_bee(State& s, int move) const
+{
+    int x = s.bee.x;
+    int y = s.bee.y;
+    switch (move) {
+    case GameEngine::Left: x--; break;
+    case GameEngine::Right: x++; break;
+    case GameEngine::Up: y--; break;
+    case GameEngine::Down: y++; break;
+    default: break;
+    }
+    if(x < 0 || y < 0 || x >= board_size || y >= board_size || is_obstacle(x, y))
+        return false;
+
+    s.hash ^= key(BeeKey, int64_t(s.bee.y)*board_size + s.bee.x) ^ key(BeeKey, int64_t(y)*board_size + x);
+    s.bee = Cell{x, y};
+    s.hash ^= counts_key(s);
+
+    if(x == s.flower.x && y == s.flower.y)
+    {
+        s.counter++;
+        if(s.counter*10 <= 100)
+            s.progress = s.counter*10;
+    }
+
+    if(is_opp(x, y))
+        s.over = true;
+    for(size_t i = 0; i < s.enemies.size(); i++)
+    {
+        if(s.enemies[i].x == x && s.enemies[i].y == y)
+            s.over = true;
+    }
+
+    if(x == hive.x && y == hive.y && s.progress == 100)
+    {
+        s.counter %= 10;
+        s.progress = 0;
+        s.score++;
+    }
+    s.hash ^= counts_key(s);
+    return true;
+}
+
+/*
+ * Function to pick one of the places a new flower (and an opp and obstacle,
+ * if it is time for one) could go. The places come from the position's
+ * hash, so the same position always gets the same ones.
+ *
+ * @param sample is which of the places to pick
+ */
+void Planner::place_spawns(State& s, int sample)
+{
+    CounterRng rng(s.hash, CounterRng::Flower, sample, 0);
+    int tries = 0;
+
+    int x, y;
+    do
+    {
+        x = rng.below(board_size);
+        y = rng.below(board_size);
+    } while(!free_for_spawn(s, x, y) && ++tries < 64);
+
+    s.hash ^= key(FlowerKey, int64_t(s.flower.y)*board_size + s.flower.x) ^ key(FlowerKey, int64_t(y)*board_size + x);
+    s.flower = Cell{x, y};
+
+    if(s.counter == 0 || s.counter % opp_time != 0)
+        return;
+
+    for(int kind = 0; kind < (obstacles ? 2 : 1); kind++)
+    {
+        tries = 0;
+        do
+        {
+            x = rng.below(board_size);
+            y = rng.below(board_size);
+        } while((!free_for_spawn(s, x, y) || (x == s.flower.x && y == s.flower.y)) && ++tries < 64);
+        if(tries >= 64)
+            return;
+
+        int64_t square = int64_t(y)*board_size + x;
+        if(kind == 0)
+        {
+            added_opps.push_back(square);
+            s.hash ^= key(OppKey, square);
+        }
+        else
+        {
+            added_walls.push_back(square);
+            s.hash ^= key(WallKey, square);
+        }
+    }
+}
+
+/*
+ * Function to move every enemy, as GameEngine::move_enemy does. An enemy
+ * that would start again somewhere else is taken out of the search.
+ */
+void Planner::move_enemies(State& s) const
+{
+    for(size_t i = 0; i < s.enemies.size() && !s.over; )
+    {
+        Enemy& e = s.enemies[i];
+
+        int bee_step = 0;
+        int bx = s.bee.x - e.x;
+        int by = s.bee.y - e.y;
+        int t = e.dx != 0 ? bx*e.dx : by*e.dy;
+        if(t >= 1 && t <= e.speed && bx == e.dx*t && by == e.dy*t)
+            bee_step = t;
+
+        int stop = e.speed + 1;
+        int steps = bee_step ? bee_step : e.speed;
+        for(int k = 1; k <= steps; k++)
+        {
+            if(stops_enemy(s, e.x + e.dx*k, e.y + e.dy*k))
+            {
+                stop = k;
+                break;
+            }
+        }
+
+        s.hash ^= enemy_key(e);
+        if(bee_step && bee_step < stop)
+        {
+            s.over = true;
+            return;
+        }
+        if(stop <= e.speed)
+        {
+            e = s.enemies.back();
+            s.enemies.pop_back();
+            continue;
+        }
+
+        e.x += e.dx*e.speed;
+        e.y += e.dy*e.speed;
+        s.hash ^= enemy_key(e);
+        i++;
+    }
+}
+
+/*
+ * Function to guess how good a position is without looking further: points
+ * for score and pollen, less the distance to where the bee should go next,
+ * less a little for each enemy close to the bee.
+ */
+double Planner::evaluate(const State& s) const
+{
+    const Cell& target = s.progress == 100 ? hive : s.flower;
+    double value = s.score*1000.0 + std::min(s.counter, 10)*50.0;
+    value -= std::abs(s.bee.x - target.x) + std::abs(s.bee.y - target.y);
+
+    for(size_t i = 0; i < s.enemies.size(); i++)
+    {
+        const Enemy& e = s.enemies[i];
+        int d = std::max(std::abs(e.x - s.bee.x), std::abs(e.y - s.bee.y));
+        if(d <= e.speed + 1)
+            value -= 20.0 / (d + 1);
+    }
+    return value;
+}
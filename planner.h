@@ -0,0 +1,133 @@
+/*
+ * @file planner.h
+ * @brief header file to contain Planner class declarations
+ *
+ * This headerfile contains the class declaration of the Planner class,
+ * which looks a few moves ahead from a GameEngine's state and picks the
+ * move that looks best. The game uses it for hints and the bot server for
+ * bots that don't want to choose their own moves.
+*/
+
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include "gameengine.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * @class Planner
+ * @brief expectimax search with a time limit, a Zobrist hash and a
+ * transposition table
+ *
+ * One step of the search is a bee move followed by one enemy move, like a
+ * bot server Step. Enemies are deterministic and move as move_enemy moves
+ * them; one that would start again somewhere else leaves the search, since
+ * where it goes is random. Scripted enemies are taken to keep the velocity
+ * they have now. Where a new flower (and opp and obstacle) appear when a
+ * flower is picked is a chance node: a few places are tried and their
+ * values averaged. The planner picks those places from the position, not
+ * from the game's seed, so it doesn't know the future. Opps removed at the
+ * hive are taken to stay.
+ *
+ * Positions are hashed Zobrist style: each piece on each square has a key
+ * and the hash is all of them xored together, changed a piece at a time as
+ * the search moves. Keys are worked out by mixing the piece and square, so
+ * big boards need no table of keys. Values found are kept in a fixed-size
+ * table by hash, so a position reached by different moves (or again on
+ * the next call) isn't searched again.
+ *
+ * The search goes one step deeper at a time until the time is up, and the
+ * move from the deepest search that finished is used. Nothing in it looks
+ * at every square, so big boards just get less deep.
+ */
+class Planner
+{
+public:
+    struct Result
+    {
+        GameEngine::Move move;
+        int depth; //steps ahead of the last search that finished, 0 if none did
+        double value;
+        size_t nodes; //positions looked at
+    };
+
+    //the table has 2^table_bits entries of 16 bytes
+    explicit Planner(int table_bits = 16);
+
+    //best move from engine's state, searching for about budget_us
+    Result plan(const GameEngine& engine, int budget_us);
+
+private:
+    struct Enemy
+    {
+        int x, y;
+        int dx, dy; //direction, each -1, 0 or 1
+        int speed;
+    };
+
+    //everything the search changes
+    struct State
+    {
+        Cell bee;
+        Cell flower;
+        int counter;
+        int progress;
+        int score;
+        bool over;
+        std::vector<Enemy> enemies;
+        uint64_t hash;
+    };
+
+    struct Entry
+    {
+        uint64_t key;
+        float value;
+        int16_t depth;
+        uint8_t move;
+        uint8_t used;
+    };
+
+    double search(int ply, int depth);
+    double after_move(int ply, int depth);
+    bool move_bee(State& s, int move) const;
+    void place_spawns(State& s, int sample);
+    void move_enemies(State& s) const;
+    double evaluate(const State& s) const;
+
+    bool is_opp(int x, int y) const;
+    bool is_obstacle(int x, int y) const;
+    bool stops_enemy(const State& s, int x, int y) const;
+    bool free_for_spawn(const State& s, int x, int y) const;
+
+    uint64_t key(int kind, int64_t what) const;
+    uint64_t enemy_key(const Enemy& e) const;
+    uint64_t counts_key(const State& s) const;
+    bool out_of_time();
+
+    //the game's settings and what the search doesn't change
+    int board_size;
+    int opp_time;
+    bool obstacles;
+    Cell hive;
+    uint64_t salt; //mixed into every key, so different games never share entries
+    std::vector<int64_t> opps; //squares, sorted
+    std::vector<int64_t> walls; //obstacle squares, sorted
+
+    //opps and obstacles added by chance nodes on the current path
+    std::vector<int64_t> added_opps;
+    std::vector<int64_t> added_walls;
+
+    std::vector<State> states; //one per ply, reused
+    std::vector<State> before_chance; //a ply's state while each chance sample is tried
+    std::vector<Entry> table;
+    uint64_t mask;
+
+    size_t nodes;
+    bool stopped;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+#endif // PLANNER_H
@@ -0,0 +1,209 @@
+/*
+ * @file reachability.cpp
+ * @brief contains class definition of Reachability class
+ *
+ * The 8 squares around a square are looked at in order going round. Runs of
+ * free squares that touch the middle square's sides are the ways through
+ * it; the blocked runs between them are the walls. Blocking the middle
+ * square joins those walls, and every wall that is already joined to
+ * another one closes off a region.
+ */
+
+#include "reachability.h"
+
+//the 8 squares around a square, in order going round
+static const int ring_dx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int ring_dy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+/*
+ * Constructor for the Reachability class. Every square starts free.
+ *
+ * @param board_sz is size of board
+ */
+Reachability::Reachability(size_t board_sz) :
+    board_size(board_sz), edge(board_sz*board_sz)
+{
+    clear();
+}
+
+/*
+ * Function to unblock every square.
+ */
+void Reachability::clear()
+{
+    size_t n = board_size*board_size + 1;
+    parent.resize(n);
+    size.assign(n, 1);
+    wall.assign(n, 0);
+    for(size_t i = 0; i < n; i++)
+        parent[i] = i;
+
+    //the edge of the board acts like a wall all the way round
+    wall[edge] = 1;
+
+    joins.clear();
+    block_start.clear();
+    blocked_cells.clear();
+}
+
+/*
+ * Function to find the group a square (or the edge) belongs to.
+ */
+int Reachability::find(int a) const
+{
+    while(parent[a] != a)
+        a = parent[a];
+    return a;
+}
+
+/*
+ * Function to join two groups, the smaller one under the bigger one.
+ */
+void Reachability::join(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    if(a == b)
+        return;
+
+    if(size[a] > size[b])
+    {
+        int t = a;
+        a = b;
+        b = t;
+    }
+
+    parent[a] = b;
+    size[b] += size[a];
+    joins.push_back(Join{a, b});
+}
+
+/*
+ * Function to get the group of a blocked square, or -1 if it is free.
+ * Squares off the board belong to the edge.
+ */
+int Reachability::group_at(int x, int y) const
+{
+    int last = board_size - 1;
+    if(x < 0 || y < 0 || x > last || y > last)
+        return find(edge);
+
+    int i = y*board_size + x;
+    return wall[i] ? find(i) : -1;
+}
+
+bool Reachability::blocked(int x, int y) const
+{
+    return wall[y*board_size + x] != 0;
+}
+
+/*
+ * Function to check if a square can be blocked without cutting the free
+ * squares in two.
+ *
+ * @param x is x coordinate of the square
+ * @param y is y coordinate of the square
+ * @return false if the square is already blocked or blocking it would
+ * leave some free square unreachable from the others
+ */
+bool Reachability::can_block(int x, int y) const
+{
+    if(blocked(x, y))
+        return false;
+
+    int groups[8];
+    for(int k = 0; k < 8; k++)
+        groups[k] = group_at(x + ring_dx[k], y + ring_dy[k]);
+
+    //start going round just after a blocked square; with none, nothing can close
+    int first = -1;
+    for(int k = 0; k < 8; k++)
+    {
+        if(groups[k] >= 0)
+        {
+            first = k;
+            break;
+        }
+    }
+    if(first < 0)
+        return true;
+
+    //walls between ways through (a way through must touch a side, the even squares)
+    int walls[4];
+    int num_walls = 0;
+    bool in_way = false;
+    bool way_touches_side = false;
+    int current_wall = groups[first];
+
+    for(int step = 1; step <= 8; step++)
+    {
+        int k = (first + step) % 8;
+
+        if(groups[k] < 0)
+        {
+            in_way = true;
+            if(k % 2 == 0)
+                way_touches_side = true;
+            continue;
+        }
+
+        //a run of free squares just ended; only count it if the bee could use it
+        if(in_way && way_touches_side)
+            walls[num_walls++] = current_wall;
+        in_way = false;
+        way_touches_side = false;
+        current_wall = groups[k];
+    }
+
+    //two walls in the same group close a loop round some free squares
+    for(int i = 0; i < num_walls; i++)
+    {
+        for(int j = i + 1; j < num_walls; j++)
+        {
+            if(walls[i] == walls[j])
+                return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Function to block a square and join it to the blocked squares around it.
+ */
+void Reachability::block(int x, int y)
+{
+    int i = y*board_size + x;
+
+    block_start.push_back(joins.size());
+    blocked_cells.push_back(i);
+    wall[i] = 1;
+
+    for(int k = 0; k < 8; k++)
+    {
+        int g = group_at(x + ring_dx[k], y + ring_dy[k]);
+        if(g >= 0)
+            join(i, g);
+    }
+}
+
+/*
+ * Function to unblock the most recently blocked square, undoing its joins.
+ */
+void Reachability::unblock_last()
+{
+    if(blocked_cells.empty())
+        return;
+
+    size_t start = block_start.back();
+    while(joins.size() > start)
+    {
+        Join j = joins.back();
+        joins.pop_back();
+        parent[j.child] = j.child;
+        size[j.root] -= size[j.child];
+    }
+
+    wall[blocked_cells.back()] = 0;
+    blocked_cells.pop_back();
+    block_start.pop_back();
+}
@@ -0,0 +1,73 @@
+/*
+ * @file reachability.h
+ * @brief header file to contain Reachability class declarations
+ *
+ * This headerfile contains the class declaration of the Reachability class,
+ * which GameEngine asks before putting down an opp or obstacle so that the
+ * free squares of the board always stay connected. Then the bee can always
+ * reach the flower and the hive, wherever they are.
+*/
+
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * @class Reachability
+ * @brief union-find over the blocked squares, with the board's edge as one
+ * extra blocked piece
+ *
+ * Blocked squares touching (including diagonally) are joined into groups.
+ * Blocking a square cuts the free squares in two exactly when the square
+ * touches the same group on two sides with free squares in between, which
+ * closes a loop. That is checked by looking at the 8 squares around it and
+ * finding their groups, without searching the board.
+ *
+ * Squares are unblocked in the reverse order they were blocked (the engine
+ * removes the newest opps and obstacles first), so unblocking just undoes
+ * the joins. Because of that there is no path compression and finding a
+ * group takes O(log n) steps.
+ */
+class Reachability
+{
+public:
+    explicit Reachability(size_t board_size = 15);
+
+    //unblock every square
+    void clear();
+
+    //true if (x,y) is free and blocking it keeps the free squares connected
+    bool can_block(int x, int y) const;
+
+    bool blocked(int x, int y) const;
+
+    //block (x,y); unblock_last() undoes the most recent block()
+    void block(int x, int y);
+    void unblock_last();
+
+private:
+    int find(int a) const;
+    void join(int a, int b);
+    int group_at(int x, int y) const;
+
+    size_t board_size;
+    int edge; //group number of the board's edge
+
+    std::vector<int> parent;
+    std::vector<int> size;
+    std::vector<unsigned char> wall;
+
+    //what each block() did, so unblock_last() can undo it
+    struct Join
+    {
+        int child;
+        int root;
+    };
+    std::vector<Join> joins;
+    std::vector<size_t> block_start; //joins.size() before each block()
+    std::vector<int> blocked_cells;
+};
+
+#endif // REACHABILITY_H
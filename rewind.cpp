@@ -0,0 +1,553 @@
+/*
+ * @file rewind.cpp
+ * @brief contains class definition of RewindBuffer class
+ *
+ * Each record in the ring is a 4 byte length, a 1 byte kind (keyframe or
+ * delta) and then the record itself. Positions are small signed 16 bit
+ * numbers; a delta starts with a byte of flags saying which parts follow,
+ * and each enemy in it has a byte of flags of its own.
+ */
+
+#include "rewind.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+//parts of a delta, in the order they are written
+enum DeltaFlags
+{
+    BeeMoved = 1,
+    FlowerMoved = 2,
+    CloudsMoved = 4,
+    OppsChanged = 8,
+    ObstaclesChanged = 16,
+    CountsChanged = 32,
+    Ticked = 64,
+    SpawnsChanged = 128
+};
+
+//parts of one enemy in a CloudsMoved delta
+enum EnemyFlags
+{
+    EnemyMoved = 1,
+    EnemyTurned = 2,
+    EnemyRescripted = 4,
+    EnemyRemembered = 8
+};
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+void put_cell(std::vector<uint8_t>& out, const Cell& c)
+{
+    put<int16_t>(out, c.x);
+    put<int16_t>(out, c.y);
+}
+
+void put_cells(std::vector<uint8_t>& out, const std::vector<Cell>& cells, size_t from)
+{
+    put<uint32_t>(out, cells.size() - from);
+    for(size_t i = from; i < cells.size(); i++)
+        put_cell(out, cells[i]);
+}
+
+/*
+ * @struct Reader
+ * @brief reads values back in the order put() wrote them
+ */
+struct Reader
+{
+    const uint8_t* p;
+
+    template <typename T>
+    T get()
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    Cell cell()
+    {
+        Cell c;
+        c.x = get<int16_t>();
+        c.y = get<int16_t>();
+        return c;
+    }
+
+    void cells(std::vector<Cell>& out)
+    {
+        uint32_t n = get<uint32_t>();
+        for(uint32_t i = 0; i < n; i++)
+            out.push_back(cell());
+    }
+};
+
+/*
+ * Functions to write and read what scripted enemies keep between ticks:
+ * a behaviour number and a mem for each enemy.
+ */
+void put_scripts(std::vector<uint8_t>& out, const GameEngine::Snapshot& s)
+{
+    for(size_t i = 0; i < s.clouds.size(); i++)
+    {
+        put<int16_t>(out, s.cloud_behaviours[i]);
+        put<int32_t>(out, s.cloud_memory[i]);
+    }
+}
+
+void get_scripts(Reader& r, GameEngine::Snapshot& s)
+{
+    s.cloud_behaviours.resize(s.clouds.size());
+    s.cloud_memory.resize(s.clouds.size());
+    for(size_t i = 0; i < s.clouds.size(); i++)
+    {
+        s.cloud_behaviours[i] = r.get<int16_t>();
+        s.cloud_memory[i] = r.get<int32_t>();
+    }
+}
+
+bool same(const Cell& a, const Cell& b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+/*
+ * Functions to write and read the enemies that changed between two ticks.
+ * Every enemy gets a byte of EnemyFlags and then only the parts that
+ * changed, so a tick where the enemies just move costs 5 bytes each
+ * instead of a full copy of them. Enemies past the end of before are new
+ * and have every part written.
+ */
+void put_enemies(std::vector<uint8_t>& out, const GameEngine::Snapshot& before, const GameEngine::Snapshot& after)
+{
+    put<uint32_t>(out, after.clouds.size());
+    for(size_t i = 0; i < after.clouds.size(); i++)
+    {
+        bool added = i >= before.clouds.size();
+        uint8_t flags = 0;
+        if(added || !same(before.clouds[i], after.clouds[i]))
+            flags |= EnemyMoved;
+        if(added || !same(before.cloud_velocities[i], after.cloud_velocities[i]))
+            flags |= EnemyTurned;
+        if(added || before.cloud_behaviours[i] != after.cloud_behaviours[i])
+            flags |= EnemyRescripted;
+        if(added || before.cloud_memory[i] != after.cloud_memory[i])
+            flags |= EnemyRemembered;
+
+        put<uint8_t>(out, flags);
+        if(flags & EnemyMoved)
+            put_cell(out, after.clouds[i]);
+        if(flags & EnemyTurned)
+            put_cell(out, after.cloud_velocities[i]);
+        if(flags & EnemyRescripted)
+            put<int16_t>(out, after.cloud_behaviours[i]);
+        if(flags & EnemyRemembered)
+            put<int32_t>(out, after.cloud_memory[i]);
+    }
+}
+
+void get_enemies(Reader& r, GameEngine::Snapshot& s)
+{
+    uint32_t n = r.get<uint32_t>();
+    s.clouds.resize(n);
+    s.cloud_velocities.resize(n);
+    s.cloud_behaviours.resize(n);
+    s.cloud_memory.resize(n);
+    for(uint32_t i = 0; i < n; i++)
+    {
+        uint8_t flags = r.get<uint8_t>();
+        if(flags & EnemyMoved)
+            s.clouds[i] = r.cell();
+        if(flags & EnemyTurned)
+            s.cloud_velocities[i] = r.cell();
+        if(flags & EnemyRescripted)
+            s.cloud_behaviours[i] = r.get<int16_t>();
+        if(flags & EnemyRemembered)
+            s.cloud_memory[i] = r.get<int32_t>();
+    }
+}
+
+//number of cells at the start of both vectors that are the same
+size_t common(const std::vector<Cell>& a, const std::vector<Cell>& b)
+{
+    size_t n = 0;
+    while(n < a.size() && n < b.size() && same(a[n], b[n]))
+        n++;
+    return n;
+}
+
+}
+
+/*
+ * Constructor for the RewindBuffer class.
+ *
+ * @param bytes is how much memory the history may use
+ * @param every is how many ticks apart keyframes are
+ */
+RewindBuffer::RewindBuffer(size_t bytes, unsigned every) :
+    ring(bytes), head(0), tail(0), next_tick(0), keyframe_every(every ? every : 1), too_big(false)
+{
+}
+
+/*
+ * Function to get how big a buffer should be for a board: at least 1MB,
+ * and enough for a few keyframes of a board full of enemies, so a game
+ * that spawns enemies everywhere still has some history. Past 1024x1024
+ * that would be over 64MB (1GB at 4096x4096), so it stops at 256MB and a
+ * bigger board full of enemies has rewind turned off instead.
+ *
+ * @param board_size is the size of the board
+ */
+size_t RewindBuffer::bytes_for(size_t board_size)
+{
+    //a keyframe holds 14 bytes for each enemy and 4 for each opp or obstacle
+    const size_t keyframes = 4;
+    const size_t most = size_t(256) << 20;
+    return std::min(most, std::max<size_t>(1 << 20, keyframes*board_size*board_size*16));
+}
+
+/*
+ * Function to forget all the history.
+ */
+void RewindBuffer::clear()
+{
+    head = 0;
+    tail = 0;
+    keys.clear();
+    next_tick = 0;
+}
+
+/*
+ * Functions to copy bytes in and out of the ring, going round to the start
+ * at the end.
+ */
+void RewindBuffer::read(uint64_t offset, void* out, size_t len) const
+{
+    size_t at = offset % ring.size();
+    size_t first = std::min(len, ring.size() - at);
+    std::memcpy(out, &ring[at], first);
+    std::memcpy(static_cast<uint8_t*>(out) + first, &ring[0], len - first);
+}
+
+void RewindBuffer::write(uint64_t offset, const void* in, size_t len)
+{
+    size_t at = offset % ring.size();
+    size_t first = std::min(len, ring.size() - at);
+    std::memcpy(&ring[at], in, first);
+    std::memcpy(&ring[0], static_cast<const uint8_t*>(in) + first, len - first);
+}
+
+/*
+ * Function to write a full copy of the game into scratch.
+ */
+void RewindBuffer::encode_keyframe(const GameEngine::Snapshot& s)
+{
+    scratch.clear();
+    put_cell(scratch, s.bee);
+    put_cell(scratch, s.flower);
+    put_cells(scratch, s.opps, 0);
+    put_cells(scratch, s.obstacles, 0);
+    put_cells(scratch, s.clouds, 0);
+    put_cells(scratch, s.cloud_velocities, 0);
+    put_scripts(scratch, s);
+    put<uint32_t>(scratch, s.counter);
+    put<uint32_t>(scratch, s.score);
+    put<uint32_t>(scratch, s.num_opps);
+    put<int8_t>(scratch, s.progress);
+    put<uint8_t>(scratch, s.over);
+    put<uint32_t>(scratch, s.seed);
+    put<uint64_t>(scratch, s.ticks);
+    put<uint32_t>(scratch, s.flowers_placed);
+    put<uint32_t>(scratch, s.opps_placed);
+}
+
+/*
+ * Function to write only what changed between two ticks into scratch.
+ * Opps and obstacles are only ever added to or removed from the end, so
+ * only the removed count and the added cells are written.
+ */
+void RewindBuffer::encode_delta(const GameEngine::Snapshot& before, const GameEngine::Snapshot& after)
+{
+    scratch.clear();
+    put<uint8_t>(scratch, 0);
+    uint8_t flags = 0;
+
+    if(!same(before.bee, after.bee))
+    {
+        flags |= BeeMoved;
+        put_cell(scratch, after.bee);
+    }
+    if(!same(before.flower, after.flower))
+    {
+        flags |= FlowerMoved;
+        put_cell(scratch, after.flower);
+    }
+    if(common(before.clouds, after.clouds) != after.clouds.size() || before.clouds.size() != after.clouds.size()
+            || common(before.cloud_velocities, after.cloud_velocities) != after.cloud_velocities.size()
+            || before.cloud_velocities.size() != after.cloud_velocities.size()
+            || before.cloud_behaviours != after.cloud_behaviours || before.cloud_memory != after.cloud_memory)
+    {
+        flags |= CloudsMoved;
+        put_enemies(scratch, before, after);
+    }
+
+    size_t keep = common(before.opps, after.opps);
+    if(keep != before.opps.size() || keep != after.opps.size())
+    {
+        flags |= OppsChanged;
+        put<uint32_t>(scratch, before.opps.size() - keep);
+        put_cells(scratch, after.opps, keep);
+    }
+
+    keep = common(before.obstacles, after.obstacles);
+    if(keep != before.obstacles.size() || keep != after.obstacles.size())
+    {
+        flags |= ObstaclesChanged;
+        put<uint32_t>(scratch, before.obstacles.size() - keep);
+        put_cells(scratch, after.obstacles, keep);
+    }
+
+    if(before.counter != after.counter || before.score != after.score || before.num_opps != after.num_opps
+            || before.progress != after.progress || before.over != after.over)
+    {
+        flags |= CountsChanged;
+        put<uint32_t>(scratch, after.counter);
+        put<uint32_t>(scratch, after.score);
+        put<uint32_t>(scratch, after.num_opps);
+        put<int8_t>(scratch, after.progress);
+        put<uint8_t>(scratch, after.over);
+    }
+
+    //the random streams only need the tick and spawn counts, not a generator's state
+    if(before.ticks != after.ticks)
+    {
+        flags |= Ticked;
+        put<uint64_t>(scratch, after.ticks);
+    }
+    if(before.seed != after.seed || before.flowers_placed != after.flowers_placed
+            || before.opps_placed != after.opps_placed)
+    {
+        flags |= SpawnsChanged;
+        put<uint32_t>(scratch, after.seed);
+        put<uint32_t>(scratch, after.flowers_placed);
+        put<uint32_t>(scratch, after.opps_placed);
+    }
+
+    scratch[0] = flags;
+}
+
+/*
+ * Function to add the record in scratch to the ring, dropping the oldest
+ * keyframes (and the deltas after them) until there is room.
+ */
+void RewindBuffer::append(Kind kind)
+{
+    uint32_t len = scratch.size();
+    uint8_t k = kind;
+    size_t total = sizeof(len) + 1 + len;
+
+    //a record that doesn't fit at all means the buffer is too small to use
+    //until the game gets smaller again
+    if(total > ring.size())
+    {
+        clear();
+        too_big = true;
+        return;
+    }
+    too_big = false;
+
+    while(head + total - tail > ring.size())
+    {
+        keys.pop_front();
+        tail = keys.empty() ? head : keys.front().offset;
+    }
+
+    if(kind == Keyframe)
+        keys.push_back(Key{next_tick, head});
+
+    write(head, &len, sizeof(len));
+    write(head + sizeof(len), &k, 1);
+    write(head + sizeof(len) + 1, scratch.data(), len);
+    head += total;
+    next_tick++;
+}
+
+/*
+ * Function to add the engine's state as the next tick. Ticks are written as
+ * deltas from the tick before, except every keyframe_every ticks and when
+ * there is no keyframe left to start from.
+ *
+ * @param engine is the game being recorded
+ */
+void RewindBuffer::record(const GameEngine& engine)
+{
+    engine.save(current);
+
+    bool key = keys.empty() || next_tick - keys.back().tick >= keyframe_every;
+    if(key)
+        encode_keyframe(current);
+    else
+        encode_delta(last, current);
+
+    //a delta that would be dropped with its keyframe needs a new keyframe;
+    //one too big to keep at all emptied the history, so it starts again
+    append(key ? Keyframe : Delta);
+    if(!key && keys.empty())
+    {
+        if(!too_big)
+            next_tick--;
+        head = tail;
+        encode_keyframe(current);
+        append(Keyframe);
+    }
+
+    std::swap(last, current);
+}
+
+/*
+ * Function to apply one record to a snapshot.
+ *
+ * @param offset is where the record starts in the ring
+ * @param s is the state before the record, changed to the state after it
+ * @return size of the record in the ring
+ */
+size_t RewindBuffer::decode(uint64_t offset, GameEngine::Snapshot& s)
+{
+    uint32_t len;
+    uint8_t kind;
+    read(offset, &len, sizeof(len));
+    read(offset + sizeof(len), &kind, 1);
+
+    body.resize(len);
+    read(offset + sizeof(len) + 1, body.data(), len);
+    Reader r = { body.data() };
+
+    if(kind == Keyframe)
+    {
+        s.bee = r.cell();
+        s.flower = r.cell();
+        s.opps.clear();
+        r.cells(s.opps);
+        s.obstacles.clear();
+        r.cells(s.obstacles);
+        s.clouds.clear();
+        r.cells(s.clouds);
+        s.cloud_velocities.clear();
+        r.cells(s.cloud_velocities);
+        get_scripts(r, s);
+        s.counter = r.get<uint32_t>();
+        s.score = r.get<uint32_t>();
+        s.num_opps = r.get<uint32_t>();
+        s.progress = r.get<int8_t>();
+        s.over = r.get<uint8_t>();
+        s.seed = r.get<uint32_t>();
+        s.ticks = r.get<uint64_t>();
+        s.flowers_placed = r.get<uint32_t>();
+        s.opps_placed = r.get<uint32_t>();
+    }
+    else
+    {
+        uint8_t flags = r.get<uint8_t>();
+
+        if(flags & BeeMoved)
+            s.bee = r.cell();
+        if(flags & FlowerMoved)
+            s.flower = r.cell();
+        if(flags & CloudsMoved)
+            get_enemies(r, s);
+        if(flags & OppsChanged)
+        {
+            s.opps.resize(s.opps.size() - r.get<uint32_t>());
+            r.cells(s.opps);
+        }
+        if(flags & ObstaclesChanged)
+        {
+            s.obstacles.resize(s.obstacles.size() - r.get<uint32_t>());
+            r.cells(s.obstacles);
+        }
+        if(flags & CountsChanged)
+        {
+            s.counter = r.get<uint32_t>();
+            s.score = r.get<uint32_t>();
+            s.num_opps = r.get<uint32_t>();
+            s.progress = r.get<int8_t>();
+            s.over = r.get<uint8_t>();
+        }
+        if(flags & Ticked)
+            s.ticks = r.get<uint64_t>();
+        if(flags & SpawnsChanged)
+        {
+            s.seed = r.get<uint32_t>();
+            s.flowers_placed = r.get<uint32_t>();
+            s.opps_placed = r.get<uint32_t>();
+        }
+    }
+
+    return sizeof(len) + 1 + len;
+}
+
+/*
+ * Function to put the engine back the way it was at a tick. The newest
+ * keyframe at or before tick is read, then the deltas up to tick.
+ *
+ * @param tick is the tick to go back to
+ * @param engine is changed to that tick's state
+ * @return false if the tick is older than the history kept, or not recorded yet
+ */
+bool RewindBuffer::restore(uint64_t tick, GameEngine& engine)
+{
+    if(keys.empty() || tick < first_tick() || tick > last_tick())
+        return false;
+
+    //keyframes are in order, find the last one at or before tick
+    size_t lo = 0, hi = keys.size();
+    while(hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if(keys[mid].tick <= tick)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    uint64_t offset = keys[lo].offset;
+    for(uint64_t t = keys[lo].tick; t <= tick; t++)
+        offset += decode(offset, current);
+
+    engine.load(current);
+    return true;
+}
+
+/*
+ * Function to throw away every tick after tick, so that the next record()
+ * becomes tick + 1. Used when play carries on from a rewound moment.
+ *
+ * @param tick is the newest tick to keep
+ */
+void RewindBuffer::truncate(uint64_t tick)
+{
+    if(keys.empty() || tick >= last_tick())
+        return;
+    if(tick < first_tick())
+    {
+        clear();
+        return;
+    }
+
+    while(keys.back().tick > tick)
+        keys.pop_back();
+
+    uint64_t offset = keys.back().offset;
+    for(uint64_t t = keys.back().tick; t <= tick; t++)
+        offset += decode(offset, last);
+
+    head = offset;
+    next_tick = tick + 1;
+}
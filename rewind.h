@@ -0,0 +1,96 @@
+/*
+ * @file rewind.h
+ * @brief header file to contain RewindBuffer class declarations
+ *
+ * This headerfile contains the class declaration of the RewindBuffer class,
+ * which remembers the last few minutes of a game so it can be stepped back
+ * through. It is used by GameBoard's rewind keys and can be used by any
+ * tool that drives a GameEngine.
+*/
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "gameengine.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/*
+ * @class RewindBuffer
+ * @brief keeps game history in a fixed amount of memory
+ *
+ * Every keyframe_every ticks a full copy of the game (a keyframe) is
+ * written, and every other tick only what changed since the tick before:
+ * the bee's move, a new flower, the enemies that moved or changed, opps
+ * and obstacles added or removed, the counters, and the tick and spawn
+ * counts the random numbers come from. When the buffer is full the oldest
+ * keyframe and the ticks after it are dropped. A tick too big for the
+ * whole buffer can't be kept; the history is emptied and overflowed()
+ * says so until a tick fits again.
+ *
+ * Going back to a tick reads its keyframe and applies at most
+ * keyframe_every - 1 changes, so it takes about the same time for any tick.
+ */
+class RewindBuffer
+{
+public:
+    explicit RewindBuffer(size_t bytes = 1 << 20, unsigned keyframe_every = 64);
+
+    //bytes to give a buffer for a game on a board this size
+    static size_t bytes_for(size_t board_size);
+
+    //add the engine's current state as the next tick
+    void record(const GameEngine& engine);
+
+    //forget everything
+    void clear();
+
+    //oldest and newest ticks that can be gone back to
+    bool empty() const { return keys.empty(); }
+    uint64_t first_tick() const { return keys.empty() ? 0 : keys.front().tick; }
+    uint64_t last_tick() const { return next_tick - 1; }
+
+    //put the engine back the way it was at tick, false if tick isn't kept
+    bool restore(uint64_t tick, GameEngine& engine);
+
+    //throw away every tick after tick, so recording carries on from there
+    void truncate(uint64_t tick);
+
+    //whether the newest tick was too big to keep, so there is no history
+    bool overflowed() const { return too_big; }
+
+private:
+    enum Kind { Keyframe = 0, Delta = 1 };
+
+    struct Key
+    {
+        uint64_t tick;
+        uint64_t offset; //where the keyframe starts in the ring
+    };
+
+    void encode_keyframe(const GameEngine::Snapshot& s);
+    void encode_delta(const GameEngine::Snapshot& before, const GameEngine::Snapshot& after);
+    void append(Kind kind);
+    size_t decode(uint64_t offset, GameEngine::Snapshot& s);
+
+    void read(uint64_t offset, void* out, size_t len) const;
+    void write(uint64_t offset, const void* in, size_t len);
+
+    std::vector<uint8_t> ring; //records, written round and round
+    uint64_t head; //where the next record goes (counts up forever)
+    uint64_t tail; //where the oldest kept record starts
+
+    std::deque<Key> keys;
+    uint64_t next_tick;
+    unsigned keyframe_every;
+    bool too_big; //see overflowed()
+
+    std::vector<uint8_t> scratch; //record being built
+    std::vector<uint8_t> body; //record being read
+    GameEngine::Snapshot last; //state at the newest tick
+    GameEngine::Snapshot current;
+};
+
+#endif // REWIND_H
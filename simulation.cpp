@@ -0,0 +1,341 @@
+/*
+ * @file simulation.cpp
+ * @brief contains class definition of Simulation class
+ *
+ * The thread takes every waiting command, runs any ticks that are due,
+ * publishes a frame if anything changed, then sleeps until the next tick
+ * or the next command. The sleep uses a mutex and condition variable, but
+ * send() only touches them when the thread is actually asleep, and then
+ * only for as long as it takes to wake it.
+ */
+
+#include "simulation.h"
+#include "trace.h"
+#include <cstdio>
+#include <cstring>
+
+//after a long stall (a suspended laptop) carry on from now instead of running every missed tick
+static const int max_catch_up = 10;
+
+/*
+ * Constructor for the Simulation class. Publishes the starting board, then
+ * starts the thread.
+ *
+ * @param board_size, opp_time, moving_enemies, obstacles and seed are
+ * passed to the GameEngine
+ * @param tick_ms is time between enemy moves, in ms
+ * @param on_frame is called on the simulation thread after each frame is
+ * published; it must not block
+ * @param enemy_script steers the moving enemies, or 0 for them to go
+ * straight
+ * @param swarm_size is how many worker bees fly alongside the bee, 0 for
+ * none
+ * @param heat is passed to GameEngine::set_heat
+ */
+Simulation::Simulation(size_t board_size, int opp_time, bool moving_enemies, bool obstacles, unsigned seed,
+                       int tick_ms, const std::function<void()>& frame_ready, const EnemyScript* enemy_script,
+                       size_t swarm_size, std::atomic<uint32_t>* heat) :
+    engine(board_size, opp_time, moving_enemies, obstacles, seed),
+    history(RewindBuffer::bytes_for(board_size)), rewind_warned(false), rewinding(false), view_tick(0), hint(-1), swarm(0), metrics(0),
+    pieces(board_size*board_size, GameEngine::Empty), row_changed(board_size, 0), published(0),
+    tick_length(std::chrono::milliseconds(tick_ms)), on_frame(frame_ready),
+    next_seq(0), drops(0), expected_seq(0), taken(0), out_of_order(0),
+    sleeping(false), stopping(false)
+{
+    //the first enemy was made without the script; make it again with it
+    if(enemy_script)
+    {
+        engine.set_enemy_behaviour(engine.add_behaviour(*enemy_script));
+        engine.reset(seed);
+    }
+
+    engine.set_heat(heat);
+    if(telemetry::enabled.load())
+    {
+        metrics = &telemetry::metrics(engine.get_difficulty());
+        engine.set_metrics(metrics);
+    }
+    if(swarm_size > 0)
+        swarm = new Swarm(board_size, swarm_size, seed);
+
+    //the first tick is the starting board
+    remember();
+    publish();
+
+    worker = std::thread(&Simulation::run, this);
+}
+
+/*
+ * Destructor for the Simulation class. Stops the thread and waits for it.
+ */
+Simulation::~Simulation()
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        wake.notify_one();
+    }
+    worker.join();
+    delete swarm;
+}
+
+/*
+ * Function to pass a command to the simulation thread. Never waits for the
+ * thread to get to it.
+ *
+ * @param kind is what to do
+ * @param arg is the move or rewind direction
+ * @return false if the queue was full and the command was dropped
+ */
+bool Simulation::send(CommandKind kind, int arg)
+{
+    //dropped commands use up a number too, so the thread sees the gap
+    Command c = { static_cast<uint8_t>(kind), static_cast<int8_t>(arg), next_seq++ };
+    if(!commands.push(c))
+    {
+        drops++;
+        return false;
+    }
+
+    //either the thread sees the command before it sleeps, or this sees it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(sleeping.load())
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        wake.notify_one();
+    }
+    return true;
+}
+
+/*
+ * Function to check whether enemies or workers should be moving.
+ */
+bool Simulation::ticking() const
+{
+    return (engine.has_moving_enemies() || swarm) && !rewinding && !engine.is_over();
+}
+
+/*
+ * Function to add the engine's state to the rewind history. If a tick is
+ * too big for the history (scripts can spawn an enemy on every square) it
+ * is said once, and the window is told through the frame.
+ */
+void Simulation::remember()
+{
+    history.record(engine);
+    if(history.overflowed() && !rewind_warned)
+    {
+        std::fprintf(stderr, "simulation: too many enemies to keep in the rewind history, rewind is off\n");
+        rewind_warned = true;
+    }
+}
+
+/*
+ * Function to carry out one command, the same way GameBoard's keys used to.
+ * An arrow key while rewinding carries on from the tick being shown.
+ *
+ * @return true if anything that is drawn changed
+ */
+bool Simulation::apply(const Command& c)
+{
+    if(c.kind == Press)
+    {
+        bool resumed = false;
+        if(rewinding)
+        {
+            if(engine.is_over())
+                return false;
+            history.truncate(view_tick);
+            rewinding = false;
+            resumed = true;
+        }
+
+        uint64_t start = metrics ? trace::now_ns() : 0;
+        if(!engine.press(static_cast<GameEngine::Move>(c.arg)))
+            return resumed;
+        remember();
+        hint = -1;
+        if(metrics)
+        {
+            metrics->moves.add();
+            metrics->move_ns.record(trace::now_ns() - start);
+        }
+        return true;
+    }
+
+    //the planner gets 5ms, about what a frame can wait
+    if(c.kind == Hint)
+    {
+        if(rewinding || engine.is_over())
+            return false;
+        hint = planner.plan(engine, 5000).move;
+        return true;
+    }
+
+    if(c.kind == Rewind)
+    {
+        if(history.empty())
+            return false;
+
+        if(!rewinding)
+        {
+            rewinding = true;
+            view_tick = history.last_tick();
+        }
+
+        if(c.arg < 0 && view_tick > history.first_tick())
+            view_tick--;
+        if(c.arg > 0 && view_tick < history.last_tick())
+            view_tick++;
+
+        history.restore(view_tick, engine);
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Function to write the engine's state into the next frame and hand it to
+ * the reader. Only the squares the engine changed are worked out again.
+ */
+void Simulation::publish()
+{
+    TRACE_SCOPE("publish");
+
+    uint64_t number = published + 1;
+    size_t board_size = engine.get_board_size();
+    const std::vector<int>& changed = engine.changed_cells();
+    for(size_t i = 0, n = changed.size(); i < n; i++)
+    {
+        pieces[changed[i]] = engine.piece_at(changed[i] % board_size, changed[i] / board_size);
+        row_changed[changed[i] / board_size] = number;
+    }
+    engine.clear_changed();
+
+    //assigning into the reused frame keeps the vectors' memory. Its pieces
+    //were right as of the frame it last held, so only rows changed since
+    //then are copied; the first time it is used they are all copied
+    Frame& f = frames.back();
+    if(f.pieces.size() != pieces.size())
+        f.pieces = pieces;
+    else
+    {
+        for(size_t y = 0; y < board_size; y++)
+        {
+            if(row_changed[y] > f.number)
+                std::memcpy(&f.pieces[y*board_size], &pieces[y*board_size], board_size);
+        }
+    }
+    f.number = published = number;
+    f.row_changed = row_changed;
+    f.tick = rewinding ? view_tick : history.last_tick();
+    f.bee = engine.bee();
+    f.clouds = engine.clouds();
+    f.cloud_velocities = engine.cloud_velocities();
+    f.progress = engine.get_progress();
+    f.score = engine.get_score();
+    f.hive_ready = engine.hive_ready();
+    f.over = engine.is_over();
+    f.rewinding = rewinding;
+    f.hint = hint;
+    f.commands_taken = taken;
+    f.commands_out_of_order = out_of_order;
+    f.rewind_off = history.overflowed();
+    if(swarm)
+    {
+        swarm->squares(f.workers);
+        f.swarm_pollen = swarm->delivered();
+    }
+    else
+    {
+        f.workers.clear();
+        f.swarm_pollen = 0;
+    }
+    frames.publish();
+
+    if(on_frame)
+        on_frame();
+}
+
+/*
+ * Function run by the simulation thread until the Simulation is destroyed.
+ * Ticks are due every tick_length from when ticking started, however late
+ * the thread wakes up, so enemies keep an even speed.
+ */
+void Simulation::run()
+{
+    typedef std::chrono::steady_clock clock;
+    clock::time_point next = clock::now() + tick_length;
+    bool was_ticking = ticking();
+
+    //counted here, not in the constructor, so every counter in metrics is
+    //only added to by this thread
+    if(metrics)
+        metrics->games.add();
+
+    while(!stopping)
+    {
+        bool changed = false;
+        uint64_t taken_before = taken;
+        Command c;
+        while(commands.pop(c))
+        {
+            //a command after a dropped one is a gap, not out of order
+            if(int32_t(c.seq - expected_seq) < 0)
+                out_of_order++;
+            expected_seq = c.seq + 1;
+            taken++;
+            changed |= apply(c);
+        }
+        //even commands that changed nothing are counted in the next frame
+        changed |= taken != taken_before;
+
+        //ticks start counting again after a pause
+        if(ticking() && !was_ticking)
+            next = clock::now() + tick_length;
+
+        if(ticking())
+        {
+            clock::time_point now = clock::now();
+            if(now - next > tick_length*max_catch_up)
+                next = now;
+
+            while(next <= now && ticking())
+            {
+                uint64_t start = metrics ? trace::now_ns() : 0;
+                if(engine.has_moving_enemies())
+                {
+                    engine.move_enemy();
+                    remember();
+                }
+                if(swarm)
+                    swarm->step(engine);
+                if(metrics)
+                {
+                    metrics->ticks.add();
+                    metrics->tick_ns.record(trace::now_ns() - start);
+                }
+                next += tick_length;
+                changed = true;
+            }
+        }
+        was_ticking = ticking();
+
+        if(changed)
+            publish();
+
+        //sleep until a command arrives, or the next tick if enemies are moving
+        sleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            auto woken = [this] { return stopping.load() || !commands.empty(); };
+            if(was_ticking)
+                wake.wait_until(lock, next, woken);
+            else
+                wake.wait(lock, woken);
+        }
+        sleeping = false;
+    }
+}
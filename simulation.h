@@ -0,0 +1,154 @@
+/*
+ * @file simulation.h
+ * @brief header file to contain Simulation class declarations
+ *
+ * This headerfile contains the class declaration of the Simulation class,
+ * which runs a GameEngine on its own thread. GameBoard sends it key presses
+ * and shows the frames it publishes, so a slow paint never holds up a game
+ * tick and a tick never holds up a paint.
+*/
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "gameengine.h"
+#include "rewind.h"
+#include "planner.h"
+#include "spscqueue.h"
+#include "swarm.h"
+#include "telemetry.h"
+#include "triplebuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * @class Simulation
+ * @brief owns the engine and its rewind history and steps them on a thread
+ *
+ * Commands go in through a lock-free queue. After every change the thread
+ * writes what is needed to draw the board into a Frame and publishes it
+ * through a triple buffer, then calls on_frame so the window knows to look.
+ * Frames say which rows changed in which frame, so on a big board only the
+ * rows that changed are copied into a frame or compared by the window.
+ *
+ * Enemies move every tick_ms, timed from a steady clock rather than from
+ * when the thread happened to wake up. If the level has no moving enemies
+ * or swarm, or the game is paused or over, the thread sleeps until a
+ * command arrives.
+ *
+ * When metrics are on (see telemetry.h) the time each move and tick takes
+ * is recorded, and the engine records the game's own metrics.
+ *
+ * In swarm mode the worker bees move after the enemies each tick. They are
+ * not part of the rewind history, so while rewinding they stay where they
+ * are and carry on from there.
+ */
+class Simulation
+{
+public:
+    enum CommandKind
+    {
+        Press = 0, //arg is a GameEngine::Move
+        Rewind, //arg is -1 to step back a tick, 1 forward, 0 to just pause
+        Hint //ask the planner for a move; arg is not used
+    };
+
+    struct Command
+    {
+        uint8_t kind;
+        int8_t arg;
+        uint32_t seq; //numbered by send(), so commands taken out of order can be noticed
+    };
+
+    //everything the window needs to draw one moment of the game
+    struct Frame
+    {
+        uint64_t tick; //tick in the rewind history
+        std::vector<uint8_t> pieces; //GameEngine::Piece of each square, row by row
+        Cell bee;
+        std::vector<Cell> clouds;
+        std::vector<Cell> cloud_velocities;
+        int progress;
+        size_t score;
+        bool hive_ready;
+        bool over;
+        bool rewinding; //an old tick is being shown and the game is paused
+        int hint; //GameEngine::Move the planner suggests, -1 if none was asked for since the last move
+        std::vector<Cell> workers; //square of each swarm worker, empty if there is no swarm
+        size_t swarm_pollen; //pollen the workers have dropped off
+        uint64_t commands_taken; //commands the thread has carried out (or ignored)
+        uint64_t commands_out_of_order; //commands whose seq wasn't the one after the last
+        bool rewind_off; //the newest tick was too big for the rewind history, so there is none
+        uint64_t number; //frames published up to and including this one
+        std::vector<uint64_t> row_changed; //number of the frame each row of pieces last changed in
+    };
+
+    Simulation(size_t board_size, int opp_time, bool moving_enemies, bool obstacles, unsigned seed,
+               int tick_ms, const std::function<void()>& on_frame, const EnemyScript* enemy_script = 0,
+               size_t swarm_size = 0, std::atomic<uint32_t>* heat = 0);
+    ~Simulation();
+
+    //add a command; false if too many are waiting and it was dropped
+    bool send(CommandKind kind, int arg = 0);
+
+    //commands given to send(), and how many of those were dropped; only for
+    //the thread that sends
+    uint64_t sent() const { return next_seq; }
+    uint64_t dropped() const { return drops; }
+
+    //take the newest frame; false if it is the same one as last time
+    bool update() { return frames.update(); }
+    const Frame& frame() const { return frames.front(); }
+
+private:
+    void run();
+    bool apply(const Command& c);
+    bool ticking() const;
+    void remember();
+    void publish();
+
+    GameEngine engine;
+    RewindBuffer history; //last few minutes of the game, for the rewind keys
+    bool rewind_warned; //whether it has been said that the history is too small
+    bool rewinding; //whether an old tick is being shown (game is paused)
+    uint64_t view_tick; //tick being shown while rewinding
+
+    Planner planner;
+    int hint;
+
+    Swarm* swarm; //0 unless in swarm mode
+
+    telemetry::Metrics* metrics; //this difficulty's, or 0 if metrics are off
+
+    //squares as they should be drawn, kept up to date from the engine's changed squares
+    std::vector<uint8_t> pieces;
+    std::vector<uint64_t> row_changed; //see Frame
+    uint64_t published;
+
+    std::chrono::steady_clock::duration tick_length;
+    std::function<void()> on_frame;
+
+    SpscQueue<Command, 256> commands;
+    uint32_t next_seq; //written by the sending thread only
+    uint64_t drops;
+    uint32_t expected_seq; //written by the simulation thread only
+    uint64_t taken;
+    uint64_t out_of_order;
+    TripleBuffer<Frame> frames;
+
+    //only used to sleep until a command arrives or the next tick
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping;
+    std::atomic<bool> stopping;
+
+    std::thread worker;
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,93 @@
+/*
+ * @file spriteatlas.cpp
+ * @brief contains the sprite atlas lookup functions
+ *
+ * The atlas is a few dozen entries, so looking a sprite up is a simple
+ * search through the entries. Images for sizes that are in the atlas are
+ * read-only QImages over the atlas array, so nothing is decoded or copied.
+ * Pixmaps have to be converted from those, so each one is made once and
+ * kept in QPixmapCache, which Qt empties before the application goes.
+ */
+
+#include "spriteatlas.h"
+#include <QPixmapCache>
+#include <cstring>
+
+//made by tools/spritepack at build time
+extern const unsigned char sprite_atlas_data[];
+
+namespace {
+
+const SpriteAtlasHeader* header()
+{
+    return reinterpret_cast<const SpriteAtlasHeader*>(sprite_atlas_data);
+}
+
+const SpriteAtlasEntry* entries()
+{
+    return reinterpret_cast<const SpriteAtlasEntry*>(sprite_atlas_data + sizeof(SpriteAtlasHeader));
+}
+
+/*
+ * Function to wrap an atlas entry in a QImage without copying it.
+ */
+QImage wrap(const SpriteAtlasEntry& e)
+{
+    return QImage(sprite_atlas_data + e.offset, e.width, e.height, e.width*4, QImage::Format_ARGB32_Premultiplied);
+}
+
+}
+
+/*
+ * Function to get a sprite from the atlas.
+ *
+ * @param name is the sprite's name, the image file name without extension
+ * @param side is the width and height wanted, 0 for the size it was packed at
+ * @return the image, or a null image if the atlas has no such sprite
+ */
+QImage SpriteAtlas::image(const char* name, int side)
+{
+    if(std::memcmp(header()->magic, "BSPA", 4) != 0)
+        return QImage();
+
+    const SpriteAtlasEntry* biggest = 0;
+    for(quint32 i = 0; i < header()->count; i++)
+    {
+        const SpriteAtlasEntry& e = entries()[i];
+        if(std::strncmp(e.name, name, sizeof(e.name)) != 0)
+            continue;
+
+        if(side == 0 || (int(e.width) == side && int(e.height) == side))
+            return wrap(e);
+
+        if(!biggest || e.width > biggest->width)
+            biggest = &e;
+    }
+
+    //board size the atlas wasn't packed for
+    if(biggest)
+        return wrap(*biggest).scaled(side, side, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    return QImage();
+}
+
+/*
+ * Function to get a sprite from the atlas as a QPixmap. It is converted
+ * the first time it is asked for and the same pixmap is shared after that.
+ * Like any QPixmap, only for the GUI thread.
+ *
+ * @param name is the sprite's name, the image file name without extension
+ * @param side is the width and height wanted, 0 for the size it was packed at
+ */
+QPixmap SpriteAtlas::pixmap(const char* name, int side)
+{
+    QString key = QString("sprite:%1:%2").arg(QLatin1String(name)).arg(side);
+
+    QPixmap p;
+    if(!QPixmapCache::find(key, &p))
+    {
+        p = QPixmap::fromImage(image(name, side));
+        QPixmapCache::insert(key, p);
+    }
+    return p;
+}
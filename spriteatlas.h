@@ -0,0 +1,55 @@
+/*
+ * @file spriteatlas.h
+ * @brief header file to contain the sprite atlas layout and lookup
+ *
+ * The board sprites are not decoded when the game runs. At build time
+ * tools/spritepack decodes each one, scales it to the square sizes the board
+ * uses, converts it to premultiplied ARGB and writes all of them into one
+ * array that is compiled into the program (spriteatlas_data.cpp). At run time
+ * a QImage points straight at that array.
+ *
+ * The array starts with a SpriteAtlasHeader, then count SpriteAtlasEntry
+ * records, then the pixels of each entry starting at its offset (a multiple
+ * of 16). Pixels are 32-bit words in the byte order of the build machine.
+*/
+
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include <QtGlobal>
+
+struct SpriteAtlasHeader
+{
+    char magic[4]; //"BSPA"
+    quint32 count;
+};
+
+struct SpriteAtlasEntry
+{
+    char name[24];
+    quint32 width;
+    quint32 height;
+    quint32 offset; //from the start of the atlas
+    quint32 reserved;
+};
+
+#ifndef SPRITEPACK_TOOL
+
+#include <QImage>
+#include <QPixmap>
+
+namespace SpriteAtlas {
+
+//image called name at side x side pixels, wrapping the atlas memory if the
+//atlas has that size, otherwise scaled from the biggest size it has
+QImage image(const char* name, int side);
+
+//same as image(), for widgets that need a QPixmap; converted once per
+//name and side, then shared
+QPixmap pixmap(const char* name, int side);
+
+}
+
+#endif
+
+#endif // SPRITEATLAS_H
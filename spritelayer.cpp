@@ -0,0 +1,260 @@
+/*
+ * @file spritelayer.cpp
+ * @brief contains class definition of SpriteLayer class
+ *
+ * Each sprite remembers where it was drawn when it was last moved and
+ * where it is going. Every frame its position is found by going part of
+ * the way between the two, depending on how much of the slide has passed.
+ */
+
+#include "spritelayer.h"
+#include "trace.h"
+#include <QPainter>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QResizeEvent>
+
+/*
+ * Constructor for the SpriteLayer class. Covers the parent widget and lets
+ * mouse clicks through to it.
+ *
+ * @param parent is the board the sprites are drawn over
+ * @param board_sz is number of squares along each side of the board
+ */
+SpriteLayer::SpriteLayer(QWidget *parent, size_t board_sz) :
+    QWidget(parent), board_size(board_sz)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setGeometry(parent->rect());
+    raise();
+
+    //squares fill the width until set_view() says otherwise
+    view_origin = QPointF(0, 0);
+    view_side = qreal(width()) / board_size;
+
+    //draw once per screen refresh while something is moving
+    qreal refresh = 60;
+    if(QGuiApplication::primaryScreen())
+        refresh = QGuiApplication::primaryScreen()->refreshRate();
+    if(refresh < 30)
+        refresh = 60;
+    frame_timer.setTimerType(Qt::PreciseTimer);
+    frame_timer.setInterval(qRound(1000 / refresh));
+    connect(&frame_timer, SIGNAL(timeout()), this, SLOT(next_frame()));
+
+    clock.start();
+}
+
+/*
+ * Function to add a sprite. It starts hidden in the top left square.
+ *
+ * @param image is drawn scaled to one square
+ * @return number used to refer to the sprite
+ */
+int SpriteLayer::add_sprite(const QPixmap& image)
+{
+    Sprite s;
+    s.image = image;
+    s.from = QPointF(0, 0);
+    s.to = QPoint(0, 0);
+    s.start = 0;
+    s.duration = 0;
+    s.visible = false;
+    s.drawn = square(s.from);
+
+    int side = qRound(view_side);
+    if(side > 0)
+        s.scaled = image.scaled(side, side, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    sprites.push_back(s);
+    return sprites.size() - 1;
+}
+
+/*
+ * Function to find where a sprite should be drawn, in squares. If the
+ * sprite is part way through its slide, this is part way between squares.
+ */
+QPointF SpriteLayer::position(const Sprite& s, qint64 now) const
+{
+    if(!moving(s, now))
+        return QPointF(s.to);
+
+    qreal t = qreal(now - s.start) / s.duration;
+
+    //ease out so the sprite settles into the square
+    t = 1 - (1 - t)*(1 - t);
+    return s.from + (QPointF(s.to) - s.from)*t;
+}
+
+/*
+ * Function to check whether a sprite is still sliding.
+ */
+bool SpriteLayer::moving(const Sprite& s, qint64 now) const
+{
+    return s.duration > 0 && now - s.start < s.duration;
+}
+
+/*
+ * Function to start a sprite moving. If it is part way through another
+ * slide, the new slide starts from where it is drawn now so it never jumps.
+ *
+ * @param id is the sprite
+ * @param x is x coordinate of the square to go to
+ * @param y is y coordinate of the square to go to
+ * @param duration_ms is how long the slide takes, 0 to jump straight there
+ */
+void SpriteLayer::move_sprite(int id, int x, int y, int duration_ms)
+{
+    Sprite& s = sprites[id];
+    if(s.to == QPoint(x, y))
+        return;
+
+    qint64 now = clock.elapsed();
+    QPointF old = position(s, now);
+
+    s.from = old;
+    s.to = QPoint(x, y);
+    s.start = now;
+    s.duration = duration_ms;
+
+    if(duration_ms > 0 && !frame_timer.isActive())
+        frame_timer.start();
+
+    //the square it was drawn in and the square it is drawn in now need redrawing
+    update(s.drawn);
+    s.drawn = square(position(s, now));
+    update(s.drawn);
+}
+
+/*
+ * Function to find the part of the widget covered by a sprite at a position.
+ *
+ * @param pos is the position in squares
+ */
+QRect SpriteLayer::square(const QPointF& pos) const
+{
+    return QRectF(view_origin + pos*view_side, QSizeF(view_side, view_side)).toAlignedRect();
+}
+
+/*
+ * Function to scale every sprite's image to the current square size.
+ */
+void SpriteLayer::scale_sprites()
+{
+    int side = qRound(view_side);
+    if(side <= 0)
+        return;
+
+    for(size_t i = 0, n = sprites.size(); i < n; i++)
+        sprites[i].scaled = sprites[i].image.scaled(side, side, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+/*
+ * Function to move and scale the sprites with the board. Images are only
+ * scaled again if the square size changed by at least a pixel.
+ *
+ * @param origin is where the top left corner of square (0,0) is drawn
+ * @param side is the size of a square in pixels
+ */
+void SpriteLayer::set_view(const QPointF& origin, qreal side)
+{
+    if(parentWidget() && geometry() != parentWidget()->rect())
+        setGeometry(parentWidget()->rect());
+
+    bool rescale = qRound(side) != qRound(view_side);
+    view_origin = origin;
+    view_side = side;
+    if(rescale)
+        scale_sprites();
+
+    qint64 now = clock.elapsed();
+    for(size_t i = 0, n = sprites.size(); i < n; i++)
+        sprites[i].drawn = square(position(sprites[i], now));
+
+    //everything moved
+    update();
+}
+
+/*
+ * Function to get the square a sprite is in, or is sliding to.
+ */
+QPoint SpriteLayer::sprite_square(int id) const
+{
+    return sprites[id].to;
+}
+
+/*
+ * Function to show or hide a sprite.
+ */
+void SpriteLayer::set_sprite_visible(int id, bool visible)
+{
+    if(sprites[id].visible == visible)
+        return;
+
+    sprites[id].visible = visible;
+    update(sprites[id].drawn);
+}
+
+/*
+ * Function called once per frame while something is sliding. Works out
+ * where each sprite is now and asks for only those squares to be redrawn.
+ */
+void SpriteLayer::next_frame()
+{
+    qint64 now = clock.elapsed();
+    bool any = false;
+
+    for(size_t i = 0, n = sprites.size(); i < n; i++)
+    {
+        Sprite& s = sprites[i];
+        if(moving(s, now))
+            any = true;
+
+        QRect now_at = square(position(s, now));
+        if(now_at == s.drawn)
+            continue;
+
+        update(s.drawn);
+        s.drawn = now_at;
+        update(s.drawn);
+    }
+
+    //once everything has reached its square the timer stops
+    if(!any)
+        frame_timer.stop();
+}
+
+/*
+ * Function to draw every visible sprite where the last frame put it.
+ *
+ * @param e is QPaintEvent object called
+ */
+void SpriteLayer::paintEvent(QPaintEvent *e)
+{
+    TRACE_SCOPE("paintEvent");
+
+    QPainter painter(this);
+    painter.setClipRegion(e->region());
+
+    for(size_t i = 0, n = sprites.size(); i < n; i++)
+    {
+        const Sprite& s = sprites[i];
+        if(s.visible && e->region().intersects(s.drawn))
+            painter.drawPixmap(s.drawn.topLeft(), s.scaled);
+    }
+}
+
+/*
+ * Function to work out where the sprites are drawn when the layer changes
+ * size. Square sizes come from set_view(), so nothing is scaled here.
+ *
+ * @param e is QResizeEvent object called
+ */
+void SpriteLayer::resizeEvent(QResizeEvent *e)
+{
+    qint64 now = clock.elapsed();
+    for(size_t i = 0, n = sprites.size(); i < n; i++)
+        sprites[i].drawn = square(position(sprites[i], now));
+
+    QWidget::resizeEvent(e);
+}
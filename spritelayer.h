@@ -0,0 +1,79 @@
+/*
+ * @file spritelayer.h
+ * @brief header file to contain SpriteLayer class declarations
+ *
+ * This headerfile contains the class declaration of the SpriteLayer class,
+ * a see-through widget laid over the board that draws the pieces that move
+ * (the bee and the cloud). Instead of jumping from square to square they
+ * slide between squares, drawn once per screen refresh while moving.
+*/
+
+#ifndef SPRITELAYER_H
+#define SPRITELAYER_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QPointF>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <vector>
+
+/*
+ * @class SpriteLayer
+ * @brief draws moving pieces between their old and new squares
+ *
+ * The game itself still moves a whole square at a time; this class only
+ * decides where to draw. The frame timer only runs while something is
+ * sliding, so nothing is drawn when nothing moves.
+ */
+class SpriteLayer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SpriteLayer(QWidget *parent, size_t board_size);
+
+    //returns the number used to refer to the new sprite
+    int add_sprite(const QPixmap& image);
+
+    //slide to a square over duration_ms, or jump there if duration_ms is 0
+    void move_sprite(int id, int x, int y, int duration_ms);
+    void set_sprite_visible(int id, bool visible);
+    QPoint sprite_square(int id) const;
+
+    //where square (0,0) is drawn and how big squares are, when the board is panned or zoomed
+    void set_view(const QPointF& origin, qreal side);
+
+    void paintEvent(QPaintEvent *e);
+    void resizeEvent(QResizeEvent *e);
+
+private slots:
+    void next_frame();
+
+private:
+    struct Sprite
+    {
+        QPixmap image;
+        QPixmap scaled; //image at the current square size
+        QPointF from; //square it started sliding from
+        QPoint to; //square it is going to
+        qint64 start; //clock time the slide started, in ms
+        int duration; //length of the slide in ms
+        bool visible;
+        QRect drawn; //where it is drawn this frame
+    };
+
+    QPointF position(const Sprite& s, qint64 now) const;
+    bool moving(const Sprite& s, qint64 now) const;
+    QRect square(const QPointF& pos) const;
+    void scale_sprites();
+
+    std::vector<Sprite> sprites;
+    size_t board_size;
+    QPointF view_origin;
+    qreal view_side;
+    QTimer frame_timer;
+    QElapsedTimer clock;
+};
+
+#endif // SPRITELAYER_H
@@ -0,0 +1,87 @@
+/*
+ * @file spscqueue.h
+ * @brief header file to contain the SpscQueue class template
+ *
+ * This headerfile contains the SpscQueue class template, a fixed size queue
+ * that one thread puts things into and one other thread takes them out of,
+ * without either thread ever waiting for a lock. GameBoard uses it to pass
+ * key presses to the simulation thread.
+*/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * @class SpscQueue
+ * @brief ring of N items with one writer and one reader
+ *
+ * head and tail count up forever; the item at a count is stored at
+ * count % N. The writer only changes tail and the reader only changes head,
+ * so each just has to see the other's latest value. They are kept on
+ * separate cache lines so the two threads don't slow each other down;
+ * that is done with padding rather than alignas, since new only keeps
+ * alignas past 16 bytes from C++17 on.
+ *
+ * N must be a power of two.
+ */
+template <typename T, size_t N>
+class SpscQueue
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "queue size must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    /*
+     * Function to add an item. Only the writing thread may call it.
+     *
+     * @return false if the queue is full and the item was not added
+     */
+    bool push(const T& item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == N)
+            return false;
+
+        items[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+     * Function to take the oldest item. Only the reading thread may call it.
+     *
+     * @return false if the queue is empty
+     */
+    bool pop(T& item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire))
+            return false;
+
+        item = items[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    //a whole line of padding puts what follows on a different cache line
+    //from what came before, wherever the queue starts
+    static const size_t cache_line = 64;
+
+    T items[N];
+    char pad_items[cache_line];
+    std::atomic<size_t> head; //next item to take
+    char pad_head[cache_line];
+    std::atomic<size_t> tail; //where the next item goes
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,443 @@
+/*
+ * @file swarm.cpp
+ * @brief contains class definition of Swarm class
+ *
+ * A tick is: note where the flower, hive, opps, obstacles and enemies are,
+ * sort the workers into the grid, then steer and move them, split across
+ * the threads the same way VecEnv splits its games. Nothing is allocated
+ * once the first tick is done.
+ */
+
+#include "swarm.h"
+#include "counterrng.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+//how far a worker looks for other workers, and how close is too close
+static const float neighbour_radius = 1.5f;
+static const float separation_radius = 0.7f;
+
+//most workers used, and most looked at, for each worker, so a crowd at the
+//flower or hive costs no more than a few workers
+static const int max_neighbours = 12;
+static const int max_looked = 32;
+
+//squares per tick
+static const float max_speed = 1.0f;
+
+//how far enemies are noticed, and the size of the cells they are sorted into
+static const float enemy_radius = 4.0f;
+static const int enemy_cell = 8;
+
+//how strongly each thing steers a worker
+static const float goal_weight = 0.35f;
+static const float separation_weight = 0.15f;
+static const float alignment_weight = 0.05f;
+static const float wall_weight = 0.6f;
+static const float enemy_weight = 1.5f;
+static const float wander_weight = 0.08f;
+
+//velocity kept from one tick to the next
+static const float inertia = 0.75f;
+
+/*
+ * Constructor for the Swarm class. Every worker starts at the hive.
+ *
+ * @param board_sz is the size of the board
+ * @param count is how many workers there are
+ * @param sd seeds the workers' random numbers
+ * @param num_threads is how many threads to use, 0 for one per core
+ */
+Swarm::Swarm(size_t board_sz, size_t count, uint64_t sd, size_t num_threads) :
+    board_size(board_sz), seed(sd), tick(0), pollen(0),
+    x(count), y(count), vx(count, 0), vy(count, 0), carrying(count, 0), id(count),
+    next_x(count), next_y(count), next_vx(count), next_vy(count), next_carrying(count), next_id(count),
+    delivered_by(count, 0), cell_of(count), walls(board_sz*board_sz, 0), generation(0), busy(0), stopping(false)
+{
+    //cells at least as big as the neighbour radius, and no more than 256 along a side
+    cell_size = std::max<int>(std::ceil(neighbour_radius), (board_size + 255) / 256);
+    grid_width = (board_size + cell_size - 1) / cell_size;
+    enemy_grid_width = (board_size + enemy_cell - 1) / enemy_cell;
+
+    hive = Cell{static_cast<int>(board_size) - 1, 0};
+    flower = hive;
+    for(size_t i = 0; i < count; i++)
+    {
+        CounterRng rng(seed, CounterRng::Worker, i, 0);
+        x[i] = hive.x + rng.next32() / 4294967296.0f;
+        y[i] = hive.y + rng.next32() / 4294967296.0f;
+        id[i] = i;
+    }
+
+    if(num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::min(num_threads, std::max<size_t>(count / 1024, 1));
+
+    //the calling thread is worker 0
+    threads = num_threads;
+    for(size_t w = 1; w < threads; w++)
+        workers.emplace_back(&Swarm::run, this, w);
+}
+
+/*
+ * Destructor for Swarm class. Stops the worker threads.
+ */
+Swarm::~Swarm()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(size_t w = 0; w < workers.size(); w++)
+        workers[w].join();
+}
+
+/*
+ * Function run by each worker thread. Waits for a new tick, steers its
+ * chunk of the workers, and tells the calling thread when it is finished.
+ *
+ * @param worker is the number of this thread, 1 to number of threads - 1
+ */
+void Swarm::run(size_t worker)
+{
+    size_t seen = 0;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            start_cv.wait(guard, [&]{ return stopping || generation != seen; });
+            if(stopping)
+                return;
+            seen = generation;
+        }
+
+        steer(size()*worker/threads, size()*(worker + 1)/threads);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if(--busy == 0)
+                done_cv.notify_one();
+        }
+    }
+}
+
+/*
+ * Function to wake the threads, steer the first chunk of workers on this
+ * thread, and wait for the threads to finish theirs.
+ */
+void Swarm::dispatch()
+{
+    if(threads > 1)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            busy = threads - 1;
+            generation++;
+        }
+        start_cv.notify_all();
+    }
+
+    steer(0, size()/threads);
+
+    if(threads > 1)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        done_cv.wait(guard, [&]{ return busy == 0; });
+    }
+}
+
+/*
+ * Function to move every worker one tick.
+ *
+ * @param engine is the game the swarm is in
+ */
+void Swarm::step(const GameEngine& engine)
+{
+    TRACE_SCOPE("Swarm::step");
+
+    tick++;
+    build_world(engine);
+    build_grid();
+    dispatch();
+
+    x.swap(next_x);
+    y.swap(next_y);
+    vx.swap(next_vx);
+    vy.swap(next_vy);
+    carrying.swap(next_carrying);
+
+    for(size_t i = 0, n = size(); i < n; i++)
+        pollen += delivered_by[i];
+}
+
+/*
+ * Function to note where everything the workers fly to or away from is.
+ * Only the squares marked as walls last tick are cleared, so this costs
+ * nothing like the size of the board.
+ */
+void Swarm::build_world(const GameEngine& engine)
+{
+    flower = engine.flower();
+    hive = engine.hive();
+
+    for(size_t i = 0; i < wall_squares.size(); i++)
+        walls[wall_squares[i]] = 0;
+    wall_squares.clear();
+    for(size_t i = 0; i < engine.opps().size(); i++)
+        wall_squares.push_back(engine.opps()[i].y*board_size + engine.opps()[i].x);
+    for(size_t i = 0; i < engine.obstacle_cells().size(); i++)
+        wall_squares.push_back(engine.obstacle_cells()[i].y*board_size + engine.obstacle_cells()[i].x);
+    for(size_t i = 0; i < wall_squares.size(); i++)
+        walls[wall_squares[i]] = 1;
+
+    //enemies sorted by cell, like the workers
+    const std::vector<Cell>& clouds = engine.clouds();
+    enemy_start.assign(enemy_grid_width*enemy_grid_width + 1, 0);
+    for(size_t i = 0; i < clouds.size(); i++)
+        enemy_start[(clouds[i].y / enemy_cell)*enemy_grid_width + clouds[i].x / enemy_cell + 1]++;
+    for(size_t c = 1; c < enemy_start.size(); c++)
+        enemy_start[c] += enemy_start[c - 1];
+
+    enemies.resize(clouds.size());
+    std::vector<uint32_t>& fill = cell_of; //free until build_grid
+    fill.assign(enemy_start.begin(), enemy_start.end() - 1);
+    for(size_t i = 0; i < clouds.size(); i++)
+        enemies[fill[(clouds[i].y / enemy_cell)*enemy_grid_width + clouds[i].x / enemy_cell]++] = clouds[i];
+}
+
+/*
+ * Function to sort the workers by grid cell and work out where each cell's
+ * workers start.
+ */
+void Swarm::build_grid()
+{
+    size_t n = size();
+    cell_start.assign(grid_width*grid_width + 1, 0);
+    cell_of.resize(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        int cx = std::min(int(x[i]) / cell_size, grid_width - 1);
+        int cy = std::min(int(y[i]) / cell_size, grid_width - 1);
+        cell_of[i] = cy*grid_width + cx;
+        cell_start[cell_of[i] + 1]++;
+    }
+    for(size_t c = 1; c < cell_start.size(); c++)
+        cell_start[c] += cell_start[c - 1];
+
+    //the next_ arrays are free, so the sorted workers go there and are swapped in
+    for(size_t i = 0; i < n; i++)
+    {
+        uint32_t to = cell_start[cell_of[i]]++;
+        next_x[to] = x[i];
+        next_y[to] = y[i];
+        next_vx[to] = vx[i];
+        next_vy[to] = vy[i];
+        next_carrying[to] = carrying[i];
+        next_id[to] = id[i];
+    }
+
+    //each cell's start was moved to the next cell's start; move them back
+    for(size_t c = cell_start.size() - 1; c > 0; c--)
+        cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+
+    x.swap(next_x);
+    y.swap(next_y);
+    vx.swap(next_vx);
+    vy.swap(next_vy);
+    carrying.swap(next_carrying);
+    id.swap(next_id);
+}
+
+/*
+ * Function to check if a worker can't be in a square: off the board, or an
+ * opp or obstacle.
+ */
+bool Swarm::blocked(int sx, int sy) const
+{
+    int last = board_size - 1;
+    if(sx < 0 || sy < 0 || sx > last || sy > last)
+        return true;
+    return walls[sy*board_size + sx] != 0;
+}
+
+/*
+ * Function to steer and move workers first to last - 1. Reads this tick's
+ * arrays and writes the same places of the next_ arrays.
+ */
+void Swarm::steer(size_t first, size_t last)
+{
+    float edge = board_size - 0.001f;
+    float r2 = neighbour_radius*neighbour_radius;
+    float sep2 = separation_radius*separation_radius;
+    float enemy2 = enemy_radius*enemy_radius;
+
+    for(size_t k = first; k < last; k++)
+    {
+        float px = x[k], py = y[k];
+        float pvx = vx[k], pvy = vy[k];
+        bool full = carrying[k] != 0;
+
+        //workers close by
+        float sx = 0, sy = 0, ax = 0, ay = 0;
+        int seen = 0, looked = 0;
+        int cx = std::min(int(px) / cell_size, grid_width - 1);
+        int cy = std::min(int(py) / cell_size, grid_width - 1);
+        for(int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, grid_width - 1) && looked < max_looked; gy++)
+        {
+            for(int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, grid_width - 1) && looked < max_looked; gx++)
+            {
+                int c = gy*grid_width + gx;
+                for(uint32_t j = cell_start[c], end = cell_start[c + 1]; j < end && looked < max_looked && seen < max_neighbours; j++)
+                {
+                    if(j == k)
+                        continue;
+                    looked++;
+                    float dx = px - x[j];
+                    float dy = py - y[j];
+                    float d2 = dx*dx + dy*dy;
+                    if(d2 > r2)
+                        continue;
+                    if(d2 < sep2)
+                    {
+                        float d = std::max(d2, 0.01f);
+                        sx += dx / d;
+                        sy += dy / d;
+                    }
+                    ax += vx[j];
+                    ay += vy[j];
+                    seen++;
+                }
+            }
+        }
+
+        //towards the flower, or the hive with pollen
+        const Cell& target = full ? hive : flower;
+        float gx = target.x + 0.5f - px;
+        float gy = target.y + 0.5f - py;
+        float glen = std::sqrt(gx*gx + gy*gy);
+        if(glen > 0.001f)
+        {
+            gx /= glen;
+            gy /= glen;
+        }
+
+        float fx = goal_weight*gx + separation_weight*sx;
+        float fy = goal_weight*gy + separation_weight*sy;
+        if(seen)
+        {
+            fx += alignment_weight*(ax / seen - pvx);
+            fy += alignment_weight*(ay / seen - pvy);
+        }
+
+        //away from an opp, obstacle or the edge just ahead
+        float ahead_x = px + pvx*2;
+        float ahead_y = py + pvy*2;
+        if(blocked(int(std::floor(ahead_x)), int(std::floor(ahead_y))))
+        {
+            float wx = px - (std::floor(ahead_x) + 0.5f);
+            float wy = py - (std::floor(ahead_y) + 0.5f);
+            float wlen = std::sqrt(wx*wx + wy*wy) + 0.001f;
+            //turn to the side as well as back, so workers go round instead of stopping
+            fx += wall_weight*(wx - wy*0.5f) / wlen;
+            fy += wall_weight*(wy + wx*0.5f) / wlen;
+        }
+
+        //away from enemies
+        int ex = int(px) / enemy_cell;
+        int ey = int(py) / enemy_cell;
+        for(int gy2 = std::max(ey - 1, 0); gy2 <= std::min(ey + 1, enemy_grid_width - 1); gy2++)
+        {
+            for(int gx2 = std::max(ex - 1, 0); gx2 <= std::min(ex + 1, enemy_grid_width - 1); gx2++)
+            {
+                int c = gy2*enemy_grid_width + gx2;
+                for(uint32_t j = enemy_start[c]; j < enemy_start[c + 1]; j++)
+                {
+                    float dx = px - (enemies[j].x + 0.5f);
+                    float dy = py - (enemies[j].y + 0.5f);
+                    float d2 = dx*dx + dy*dy;
+                    if(d2 < enemy2)
+                    {
+                        float d = std::max(d2, 0.25f);
+                        fx += enemy_weight*dx / d;
+                        fy += enemy_weight*dy / d;
+                    }
+                }
+            }
+        }
+
+        //a little randomness, from the worker's own stream for this tick
+        CounterRng rng(seed, CounterRng::Worker, id[k], tick);
+        fx += wander_weight*(rng.next32() / 2147483648.0f - 1);
+        fy += wander_weight*(rng.next32() / 2147483648.0f - 1);
+
+        //new velocity, no faster than max_speed
+        float nvx = pvx*inertia + fx;
+        float nvy = pvy*inertia + fy;
+        float speed = std::sqrt(nvx*nvx + nvy*nvy);
+        if(speed > max_speed)
+        {
+            nvx *= max_speed / speed;
+            nvy *= max_speed / speed;
+        }
+
+        //move, unless that would go into an opp, obstacle or off the board
+        float nx = std::min(std::max(px + nvx, 0.0f), edge);
+        float ny = std::min(std::max(py + nvy, 0.0f), edge);
+        if(blocked(int(nx), int(ny)))
+        {
+            nx = px;
+            ny = py;
+            nvx = -nvx*0.5f;
+            nvy = -nvy*0.5f;
+        }
+
+        //pick up at the flower and drop off at the hive, from the square next to it or closer
+        int qx = int(nx), qy = int(ny);
+        delivered_by[k] = 0;
+        if(!full && std::abs(qx - flower.x) <= 1 && std::abs(qy - flower.y) <= 1)
+            full = true;
+        else if(full && std::abs(qx - hive.x) <= 1 && std::abs(qy - hive.y) <= 1)
+        {
+            full = false;
+            delivered_by[k] = 1;
+        }
+
+        //an enemy on the worker's square sends it back to the hive empty
+        int ec = (qy / enemy_cell)*enemy_grid_width + qx / enemy_cell;
+        for(uint32_t j = enemy_start[ec]; j < enemy_start[ec + 1]; j++)
+        {
+            if(enemies[j].x == qx && enemies[j].y == qy)
+            {
+                nx = hive.x + 0.5f;
+                ny = hive.y + 0.5f;
+                nvx = 0;
+                nvy = 0;
+                full = false;
+                break;
+            }
+        }
+
+        next_x[k] = nx;
+        next_y[k] = ny;
+        next_vx[k] = nvx;
+        next_vy[k] = nvy;
+        next_carrying[k] = full;
+    }
+}
+
+/*
+ * Function to get the square each worker is in.
+ *
+ * @param out receives one Cell per worker
+ */
+void Swarm::squares(std::vector<Cell>& out) const
+{
+    out.resize(size());
+    for(size_t i = 0, n = size(); i < n; i++)
+        out[i] = Cell{int(x[i]), int(y[i])};
+}
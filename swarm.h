@@ -0,0 +1,116 @@
+/*
+ * @file swarm.h
+ * @brief header file to contain Swarm class declarations
+ *
+ * This headerfile contains the class declaration of the Swarm class, the
+ * worker bees of swarm mode. Workers fly from the hive to the flower and
+ * back with pollen by themselves, alongside the player's bee, keeping out
+ * of the way of each other, opps, obstacles and enemies.
+*/
+
+#ifndef SWARM_H
+#define SWARM_H
+
+#include "gameengine.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * @class Swarm
+ * @brief many worker bees, steered like a flock and moved together
+ *
+ * Workers have a position and velocity in squares, not whole squares, so
+ * they can fly smoothly; the square a worker is in is its position rounded
+ * down. Each tick a worker is steered by:
+ *  - the flower, or the hive if it is carrying pollen
+ *  - workers close by: away from ones that are too close, and the same
+ *    way as the rest (separation and alignment)
+ *  - opps and obstacles ahead of it, and enemies near it, which it turns
+ *    away from
+ *  - a little randomness, so workers with the same start spread out.
+ * A worker reaching the flower picks up pollen, and one reaching the hive
+ * with pollen drops it off. A worker an enemy lands on goes back to the
+ * hive without its pollen.
+ *
+ * Workers near each other are found with a grid of cells, rebuilt every
+ * tick by sorting the workers by cell (a counting sort). The workers are
+ * kept in that order, so the workers in one cell are next to each other in
+ * memory, and each is looked up in at most nine runs of them. Workers are
+ * split into equal chunks, one per thread; each reads the last tick's
+ * positions and writes its own part of the next, so the threads never
+ * wait for each other and the result is the same however many there are.
+ */
+class Swarm
+{
+public:
+    Swarm(size_t board_size, size_t count, uint64_t seed, size_t num_threads = 0);
+    ~Swarm();
+
+    //move every worker one tick; the world (flower, hive, opps, obstacles
+    //and enemies) is read from engine
+    void step(const GameEngine& engine);
+
+    size_t size() const { return x.size(); }
+
+    //pollen dropped at the hive since the swarm started
+    size_t delivered() const { return pollen; }
+
+    //the square each worker is in
+    void squares(std::vector<Cell>& out) const;
+
+private:
+    void dispatch();
+    void run(size_t worker);
+    void steer(size_t first, size_t last);
+    void build_grid();
+    void build_world(const GameEngine& engine);
+    bool blocked(int sx, int sy) const;
+
+    size_t board_size;
+    uint64_t seed;
+    uint64_t tick;
+    size_t pollen;
+
+    //workers, in cell order; next_* is written by steer() and swapped in
+    std::vector<float> x, y, vx, vy;
+    std::vector<uint8_t> carrying;
+    std::vector<uint32_t> id; //number of the worker, for its random stream
+    std::vector<float> next_x, next_y, next_vx, next_vy;
+    std::vector<uint8_t> next_carrying;
+    std::vector<uint32_t> next_id;
+    std::vector<uint8_t> delivered_by; //1 for each worker that dropped pollen this tick
+
+    //grid of workers: cell c's workers are cell_start[c] to cell_start[c + 1] - 1
+    int cell_size;
+    int grid_width;
+    std::vector<uint32_t> cell_start;
+    std::vector<uint32_t> cell_of;
+
+    //squares with an opp or obstacle, and the ones set last tick to clear
+    std::vector<uint8_t> walls;
+    std::vector<int> wall_squares;
+
+    //enemies, in a grid of enemy_cell squares, built the same way as the workers'
+    std::vector<Cell> enemies;
+    std::vector<uint32_t> enemy_start;
+    int enemy_grid_width;
+
+    Cell flower;
+    Cell hive;
+
+    //worker threads wait for generation to change, then do their share
+    size_t threads; //including the calling thread
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    size_t generation;
+    size_t busy;
+    bool stopping;
+};
+
+#endif // SWARM_H
@@ -0,0 +1,232 @@
+/*
+ * @file telemetry.cpp
+ * @brief contains the gameplay metrics
+ *
+ * The file is written to a temporary name and renamed over the old one, so
+ * whatever reads it never sees half a file. Histograms are written with a
+ * fixed set of bucket limits per metric; the count at a limit is every
+ * value in the buckets that end at or under it, so it may be a sixteenth
+ * low near the limit but never counts a value that was over it.
+ */
+
+#include "telemetry.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace telemetry {
+
+std::atomic<bool> enabled(false);
+
+namespace {
+
+const int difficulties = 3; //GameEngine::Difficulties
+const char* const difficulty_names[difficulties] = { "easy", "medium", "hard" };
+
+Metrics all[difficulties];
+
+std::mutex write_lock;
+std::string file_name;
+int period;
+
+//the thread that writes the file every period seconds
+std::thread writer;
+std::mutex writer_lock;
+std::condition_variable writer_wake;
+bool stopping = false;
+
+//bucket limits, in the units written out
+const double second_limits[] = { 0.5, 1, 2, 3, 5, 8, 13, 20, 30, 60, 120, 300 };
+const double latency_limits[] = { 1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4,
+                                  1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1 };
+const double opp_limits[] = { 0, 1, 2, 3, 5, 8, 13, 20, 30, 50, 80, 120, 200 };
+
+void write_counter(std::FILE* f, const char* name, const char* help, Counter Metrics::*counter)
+{
+    std::fprintf(f, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+    for(int d = 0; d < difficulties; d++)
+        std::fprintf(f, "%s{difficulty=\"%s\"} %llu\n", name, difficulty_names[d],
+                     (unsigned long long)(all[d].*counter).get());
+}
+
+/*
+ * Function to write one histogram metric for every difficulty.
+ *
+ * @param scale is what a written value is multiplied by to get a recorded
+ * one, 1e9 for values recorded in ns and written in seconds
+ */
+void write_histogram(std::FILE* f, const char* name, const char* help, Histogram Metrics::*histogram,
+                     const double* limits, int limit_count, double scale)
+{
+    std::fprintf(f, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    for(int d = 0; d < difficulties; d++)
+    {
+        const Histogram& h = all[d].*histogram;
+        const char* level = difficulty_names[d];
+
+        //a value recorded while this runs may be in a bucket but not yet the
+        //total, so buckets are kept to the total read first
+        uint64_t count = h.count();
+        for(int i = 0; i < limit_count; i++)
+        {
+            uint64_t at = h.count_at_most(uint64_t(limits[i]*scale));
+            std::fprintf(f, "%s_bucket{difficulty=\"%s\",le=\"%g\"} %llu\n", name, level, limits[i],
+                         (unsigned long long)(at < count ? at : count));
+        }
+        std::fprintf(f, "%s_bucket{difficulty=\"%s\",le=\"+Inf\"} %llu\n", name, level, (unsigned long long)count);
+        std::fprintf(f, "%s_sum{difficulty=\"%s\"} %.9g\n", name, level, h.sum() / scale);
+        std::fprintf(f, "%s_count{difficulty=\"%s\"} %llu\n", name, level, (unsigned long long)count);
+    }
+}
+
+void write_at_exit()
+{
+    {
+        std::lock_guard<std::mutex> guard(writer_lock);
+        stopping = true;
+    }
+    writer_wake.notify_one();
+    if(writer.joinable())
+        writer.join();
+    write();
+}
+
+void write_every_period()
+{
+    std::unique_lock<std::mutex> guard(writer_lock);
+    while(!stopping)
+    {
+        if(writer_wake.wait_for(guard, std::chrono::seconds(period), [] { return stopping; }))
+            return;
+        guard.unlock();
+        write();
+        guard.lock();
+    }
+}
+
+}
+
+/*
+ * Constructor for the Histogram class. Every count starts at 0.
+ */
+Histogram::Histogram() : total(0), value_sum(0)
+{
+    for(int b = 0; b < bucket_count; b++)
+        counts[b].store(0, std::memory_order_relaxed);
+}
+
+/*
+ * Function to get the largest value that goes in a bucket. For the last
+ * bucket the shift goes past the top bit and wraps to 0, so its top is the
+ * largest uint64_t, as it should be.
+ */
+uint64_t Histogram::bucket_top(int b)
+{
+    if(b < 2*sub_buckets)
+        return b;
+    int shift = b / sub_buckets - 1;
+    uint64_t top = b % sub_buckets + sub_buckets;
+    return ((top + 1) << shift) - 1;
+}
+
+/*
+ * Function to count the values recorded in buckets that end at or under v.
+ */
+uint64_t Histogram::count_at_most(uint64_t v) const
+{
+    uint64_t n = 0;
+    for(int b = 0; b < bucket_count && bucket_top(b) <= v; b++)
+        n += at(b);
+    return n;
+}
+
+/*
+ * Function to get the metrics of a difficulty.
+ *
+ * @param difficulty is a GameEngine::Difficulty
+ */
+Metrics& metrics(int difficulty)
+{
+    if(difficulty < 0 || difficulty >= difficulties)
+        difficulty = 0;
+    return all[difficulty];
+}
+
+/*
+ * Function to turn metrics on and start the thread that writes them.
+ *
+ * @param name is the file to write
+ * @param period_s is seconds between writes
+ */
+void start(const char* name, int period_s)
+{
+    {
+        std::lock_guard<std::mutex> guard(write_lock);
+        file_name = name;
+    }
+
+    if(enabled.exchange(true))
+        return;
+
+    period = period_s > 0 ? period_s : 1;
+    writer = std::thread(write_every_period);
+    std::atexit(write_at_exit);
+}
+
+/*
+ * Function to write every metric to the metrics file.
+ */
+void write()
+{
+    if(!enabled.load())
+        return;
+
+    std::lock_guard<std::mutex> guard(write_lock);
+
+    std::string temporary = file_name + ".tmp";
+    std::FILE* f = std::fopen(temporary.c_str(), "w");
+    if(!f)
+    {
+        std::perror("telemetry: can't write metrics file");
+        return;
+    }
+
+    write_counter(f, "hw4b_games_total", "Games started.", &Metrics::games);
+    write_counter(f, "hw4b_flowers_total", "Flowers picked.", &Metrics::flowers);
+    write_counter(f, "hw4b_deliveries_total", "Pollen dropped at the hive.", &Metrics::deliveries);
+    write_counter(f, "hw4b_losses_total", "Games lost to an opp or enemy.", &Metrics::losses);
+    write_counter(f, "hw4b_moves_total", "Bee moves carried out.", &Metrics::moves);
+    write_counter(f, "hw4b_ticks_total", "Enemy ticks carried out.", &Metrics::ticks);
+
+    write_histogram(f, "hw4b_flower_gap_seconds", "Time from one flower to the next in a game.",
+                    &Metrics::flower_gap_ns, second_limits, sizeof(second_limits) / sizeof(double), 1e9);
+    write_histogram(f, "hw4b_hive_delay_seconds", "Time from the progress bar filling to the drop at the hive.",
+                    &Metrics::hive_delay_ns, second_limits, sizeof(second_limits) / sizeof(double), 1e9);
+    write_histogram(f, "hw4b_opps_at_loss", "Opps on the board when a game was lost.",
+                    &Metrics::opps_at_loss, opp_limits, sizeof(opp_limits) / sizeof(double), 1);
+    write_histogram(f, "hw4b_move_duration_seconds", "Time to carry out a bee move.",
+                    &Metrics::move_ns, latency_limits, sizeof(latency_limits) / sizeof(double), 1e9);
+    write_histogram(f, "hw4b_tick_duration_seconds", "Time to carry out an enemy tick.",
+                    &Metrics::tick_ns, latency_limits, sizeof(latency_limits) / sizeof(double), 1e9);
+
+    if(std::fclose(f) != 0)
+    {
+        std::perror("telemetry: can't write metrics file");
+        return;
+    }
+
+    //rename doesn't replace an existing file everywhere; where it doesn't,
+    //the old file goes first
+    if(std::rename(temporary.c_str(), file_name.c_str()) != 0)
+    {
+        std::remove(file_name.c_str());
+        if(std::rename(temporary.c_str(), file_name.c_str()) != 0)
+            std::perror("telemetry: can't write metrics file");
+    }
+}
+
+}
@@ -0,0 +1,152 @@
+/*
+ * @file telemetry.h
+ * @brief header file to contain the gameplay metrics
+ *
+ * Counts and histograms of how games go (time between flowers, time to get
+ * pollen to the hive, opps on the board when a game is lost) and how long
+ * moves and ticks take, kept for each difficulty. A thread writes them
+ * every few seconds to a text file in the Prometheus exposition format, for
+ * a metrics agent to read from disk.
+ *
+ * Metrics are off unless start() is called (main does this when the
+ * HW4B_METRICS environment variable holds a file name). Recording a value
+ * is a few loads and stores with no locking, so it can be done on every
+ * move and tick. Times come from trace::now_ns().
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace telemetry {
+
+extern std::atomic<bool> enabled;
+
+/*
+ * @class Counter
+ * @brief a number that only goes up
+ *
+ * Like Histogram, it has one thread adding to it at a time; any thread may
+ * read it.
+ */
+class Counter
+{
+public:
+    Counter() : value(0) {}
+
+    void add(uint64_t n = 1) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value;
+};
+
+/*
+ * @class Histogram
+ * @brief how many times each value was recorded, to within 1 part in 16,
+ * for any value a uint64_t can hold
+ *
+ * Values under 32 have a bucket each. Above that, each power of two is
+ * split into 16 buckets of equal width, so a bucket is never wider than a
+ * sixteenth of the values in it (high dynamic range, as in HdrHistogram).
+ * The bucket is found from the value's highest set bit, so recording is a
+ * count-leading-zeros, a shift and three adds, with no search and no lock.
+ *
+ * One thread records at a time (the simulation thread for the game's
+ * metrics); the writer thread reads while it does. Reading while a value
+ * is recorded may see the count without the sum, which is put right by
+ * the next write.
+ */
+class Histogram
+{
+public:
+    static const int sub_bits = 4;
+    static const int sub_buckets = 1 << sub_bits;
+    static const int bucket_count = (64 - sub_bits + 1)*sub_buckets;
+
+    Histogram();
+
+    void record(uint64_t v)
+    {
+        bump(counts[bucket(v)], 1);
+        bump(total, 1);
+        bump(value_sum, v);
+    }
+
+    static int bucket(uint64_t v)
+    {
+        if(v < uint64_t(2*sub_buckets))
+            return int(v);
+        int shift = highest_bit(v) - sub_bits;
+        return shift*sub_buckets + int(v >> shift);
+    }
+
+    //position of the highest bit set in v, which isn't 0
+    static int highest_bit(uint64_t v)
+    {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#else
+        int b = 0;
+        while(v >>= 1)
+            b++;
+        return b;
+#endif
+    }
+
+    //largest value that goes in bucket b
+    static uint64_t bucket_top(int b);
+
+    uint64_t at(int b) const { return counts[b].load(std::memory_order_relaxed); }
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return value_sum.load(std::memory_order_relaxed); }
+
+    //number of values recorded that are at most v, counting only whole buckets
+    uint64_t count_at_most(uint64_t v) const;
+
+private:
+    static void bump(std::atomic<uint64_t>& a, uint64_t n)
+    {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts[bucket_count];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> value_sum;
+};
+
+/*
+ * @struct Metrics
+ * @brief everything recorded for one difficulty (GameEngine::Difficulty)
+ */
+struct Metrics
+{
+    Counter games;
+    Counter flowers; //flowers picked
+    Counter deliveries; //pollen dropped at the hive
+    Counter losses;
+    Counter moves; //bee moves the simulation carried out
+    Counter ticks; //enemy moves
+
+    Histogram flower_gap_ns; //time from one flower to the next in the same game
+    Histogram hive_delay_ns; //time from the progress bar filling to the drop at the hive
+    Histogram opps_at_loss; //opps on the board when a game was lost
+    Histogram move_ns; //time to carry out a move
+    Histogram tick_ns; //time to carry out a tick
+};
+
+//metrics of a difficulty; always the same object, whether or not metrics are on
+Metrics& metrics(int difficulty);
+
+//turn metrics on and write them to file_name every period_s seconds and at exit
+void start(const char* file_name, int period_s);
+
+//write the metrics file now
+void write();
+
+}
+
+#endif // TELEMETRY_H
@@ -0,0 +1,59 @@
+/*
+ * @file theme.cpp
+ * @brief contains definition of the Theme struct's functions
+ *
+ * The colours are the ones the stylesheets used to give: white squares and
+ * labels, a red message and a dark cyan quit button.
+ */
+
+#include "theme.h"
+
+/*
+ * Function to make the game's theme.
+ */
+static Theme make_standard()
+{
+    Theme t;
+
+    t.squares.setColor(QPalette::Window, Qt::white);
+
+    t.hud.setColor(QPalette::Window, Qt::white);
+    t.hud.setColor(QPalette::WindowText, Qt::black);
+
+    t.header_font = QFont("Impact", 20);
+    t.score_font = QFont("Impact", 14);
+    t.message_font = QFont("Impact", 10);
+
+    t.message_color = Qt::red;
+    t.bar_color = QColor(6, 176, 37);
+    t.bar_background = QColor(230, 230, 230);
+    t.bar_border = Qt::gray;
+
+    //empty, cloud, bee, hive, opp, obstacle, flower; close to the main colour of each picture
+    t.piece_colors[0] = Qt::white;
+    t.piece_colors[1] = QColor(240, 150, 60);
+    t.piece_colors[2] = QColor(250, 200, 0);
+    t.piece_colors[3] = QColor(150, 95, 40);
+    t.piece_colors[4] = QColor(90, 170, 80);
+    t.piece_colors[5] = QColor(110, 110, 120);
+    t.piece_colors[6] = QColor(230, 60, 140);
+    t.outside_board = QColor(200, 200, 200);
+    t.worker_color = QColor(190, 120, 0);
+    t.heat_color = QColor(220, 0, 0);
+    t.minimap_view = Qt::red;
+
+    t.quit_style = "background-color: darkCyan";
+
+    return t;
+}
+
+/*
+ * Function to get the game's theme. It is only made once.
+ *
+ * @return the theme, which lives until the program ends
+ */
+const Theme& Theme::standard()
+{
+    static const Theme theme = make_standard();
+    return theme;
+}
@@ -0,0 +1,51 @@
+/*
+ * @file theme.h
+ * @brief header file to contain Theme struct declarations
+ *
+ * This headerfile contains the declaration of the Theme struct, which holds
+ * the colours and fonts of the game screen. They are made once and given to
+ * widgets as palettes and fonts, instead of stylesheets that Qt has to parse
+ * and apply again to every label. The quit button is the one exception: the
+ * native styles ignore a push button's palette, so it keeps its style sheet.
+*/
+
+#ifndef THEME_H
+#define THEME_H
+
+#include <QPalette>
+#include <QFont>
+#include <QColor>
+#include <QString>
+
+/*
+ * @struct Theme
+ * @brief colours and fonts used by the game board and its header
+ */
+struct Theme
+{
+    QPalette squares; //white squares of the board
+    QPalette hud; //background and text of the header
+
+    QFont header_font; //"Keep the hive alive!"
+    QFont score_font;
+    QFont message_font; //"Time to visit the hive!" and rewind messages
+
+    QColor message_color;
+    QColor bar_color; //filled part of the progress bar
+    QColor bar_background;
+    QColor bar_border;
+
+    //colour of each GameEngine::Piece when the board is zoomed too far out for pictures
+    QColor piece_colors[7];
+    QColor outside_board; //around the board when it doesn't fill the view
+    QColor minimap_view; //outline of the part of the board being shown
+    QColor worker_color; //swarm mode's worker bees
+    QColor heat_color; //most-counted square of the heatmap overlay
+
+    QString quit_style; //style sheet of the quit button, set once when it is made
+
+    //the game's theme, made the first time it is asked for
+    static const Theme& standard();
+};
+
+#endif // THEME_H
@@ -0,0 +1,186 @@
+/*
+ * @file main.cpp
+ * @brief measure how fast a big BoardView pans at each level of detail
+ *
+ * Usage: panbench [board_size] [frames] [workers] -platform offscreen
+ *
+ * A 500x500 BoardView (the size GameBoard gives it) of a 4096x4096 board,
+ * one square in eight taken, starts zoomed all the way out. At each zoom it
+ * pans diagonally for frames frames the way a drag does, and every sixth
+ * frame, as often as enemies move, some squares change and the workers
+ * move. Each frame is drawn, minimap included, into an image. Then the
+ * wheel zooms in one doubling and it goes again, through every pyramid
+ * level, the flat colours and the pictures.
+ *
+ * It prints the time a frame took at each zoom and exits with 1 if the
+ * 99th percentile at any zoom is over 1/60 s.
+ */
+
+#include "../../boardview.h"
+#include "../../minimap.h"
+#include "../../counterrng.h"
+#include "../../trace.h"
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QStringList>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const double frame_budget_ms = 1000.0 / 60;
+static const int view_size = 500; //GameBoard's board
+static const int pan_pixels = 8; //how far a drag moves the view each frame
+static const int changes_per_tick = 64; //squares changed each time enemies move
+
+/*
+ * Function to zoom in one doubling around the middle of the view, by the
+ * same wheel event a mouse sends. Needs Qt 5.12 or later.
+ */
+static void zoom_in(BoardView& view)
+{
+    QPointF middle(view.width() / 2.0, view.height() / 2.0);
+    QWheelEvent e(middle, middle, QPoint(), QPoint(0, 600), Qt::NoButton, Qt::NoModifier, Qt::NoScrollPhase, false);
+    QApplication::sendEvent(&view, &e);
+}
+
+/*
+ * Function to get the p-th fraction of times, after sorting them.
+ */
+static double percentile(std::vector<double>& times, double p)
+{
+    std::sort(times.begin(), times.end());
+    return times[size_t(p*(times.size() - 1))];
+}
+
+/*
+ * Function to say how the view draws squares at its zoom.
+ */
+static QString detail(const BoardView& view)
+{
+    qreal side = view.square_side();
+    if(view.pictures_shown())
+        return "pictures";
+    if(side >= 1)
+        return "colours";
+    int level = qMin(view.levels() - 1, int(std::floor(std::log2(1 / side))));
+    return QString("level %1").arg(level);
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    size_t board_size = args.size() > 1 ? args[1].toUInt() : 4096;
+    int frames = args.size() > 2 ? args[2].toInt() : 120;
+    size_t worker_count = args.size() > 3 ? args[3].toUInt() : 10000;
+    if(board_size < 2 || frames < 1)
+    {
+        std::fprintf(stderr, "usage: panbench [board_size] [frames] [workers] -platform offscreen\n");
+        return 1;
+    }
+
+    const Theme& theme = Theme::standard();
+    BoardView view(board_size, theme);
+    view.resize(view_size, view_size);
+    Minimap minimap(&view);
+    view.show();
+    view.fit();
+
+    //pictures at the size GameBoard gets them; plain ones draw as fast
+    for(int p = GameEngine::Hive; p <= GameEngine::Flower; p++)
+    {
+        QPixmap picture(50, 50);
+        picture.fill(theme.piece_colors[p]);
+        view.set_picture(p, picture);
+    }
+
+    CounterRng random(1, CounterRng::Session, 0, 0);
+    size_t squares = board_size*board_size;
+
+    std::vector<uint8_t> pieces(squares, GameEngine::Empty);
+    for(size_t i = 0; i < squares; i++)
+    {
+        if(random.below(8) == 0)
+            pieces[i] = GameEngine::Hive + random.below(4);
+    }
+    std::vector<uint64_t> row_changed(board_size, 1);
+    uint64_t number = 1;
+
+    uint64_t start = trace::now_ns();
+    view.set_pieces(pieces, row_changed, 0);
+    std::printf("%zux%zu board, %zu workers: first set_pieces %.1f ms\n",
+                board_size, board_size, worker_count, (trace::now_ns() - start) / 1e6);
+
+    std::vector<Cell> workers(worker_count);
+    for(size_t i = 0; i < worker_count; i++)
+    {
+        workers[i].x = random.below(board_size);
+        workers[i].y = random.below(board_size);
+    }
+    view.set_workers(workers);
+
+    QImage screen(view.size(), QImage::Format_RGB32);
+    bool too_slow = false;
+
+    std::printf("%10s  %-9s %9s %9s %9s\n", "side", "detail", "mean ms", "p99 ms", "max ms");
+    while(true)
+    {
+        view.look_at(QPointF(board_size / 2.0, board_size / 2.0));
+
+        std::vector<double> times;
+        double total = 0;
+        for(int f = 0; f < frames; f++)
+        {
+            start = trace::now_ns();
+
+            if(f % 6 == 0)
+            {
+                number++;
+                for(int k = 0; k < changes_per_tick; k++)
+                {
+                    size_t pos = random.below(squares);
+                    pieces[pos] = random.below(2) ? GameEngine::Empty : GameEngine::Hive + random.below(4);
+                    row_changed[pos / board_size] = number;
+                }
+                view.set_pieces(pieces, row_changed, number - 1);
+
+                for(size_t i = 0; i < worker_count; i++)
+                {
+                    workers[i].x = qBound(0, workers[i].x + int(random.below(3)) - 1, int(board_size) - 1);
+                    workers[i].y = qBound(0, workers[i].y + int(random.below(3)) - 1, int(board_size) - 1);
+                }
+                view.set_workers(workers);
+            }
+
+            qreal side = view.square_side();
+            QPointF middle = (QPointF(view.width() / 2.0, view.height() / 2.0) - view.view_origin()) / side;
+            view.look_at(middle + QPointF(pan_pixels, pan_pixels) / side);
+            {
+                QPainter painter(&screen);
+                view.render(&painter);
+            }
+
+            times.push_back((trace::now_ns() - start) / 1e6);
+            total += times.back();
+        }
+
+        //percentile() sorts the times, so the last is the slowest
+        double p99 = percentile(times, 0.99);
+        std::printf("%10.3f  %-9s %9.2f %9.2f %9.2f%s\n", view.square_side(), qPrintable(detail(view)),
+                    total / frames, p99, times.back(), p99 > frame_budget_ms ? "  too slow" : "");
+        if(p99 > frame_budget_ms)
+            too_slow = true;
+
+        qreal before = view.square_side();
+        zoom_in(view);
+        if(view.square_side() == before)
+            break;
+    }
+
+    return too_slow ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Measure of how fast a big BoardView pans: draws
+# the board panning at every zoom from fitted to
+# pictures and prints how long each frame took.
+# Run by hand with -platform offscreen, it exits
+# with 1 if a zoom misses 60 fps.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets
+
+TARGET = panbench
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+SOURCES += main.cpp \
+    ../../boardview.cpp \
+    ../../minimap.cpp \
+    ../../theme.cpp \
+    ../../trace.cpp
+
+HEADERS += ../../boardview.h \
+    ../../minimap.h \
+    ../../theme.h \
+    ../../trace.h \
+    ../../gameengine.h \
+    ../../counterrng.h
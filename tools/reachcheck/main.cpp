@@ -0,0 +1,161 @@
+/*
+ * @file main.cpp
+ * @brief check Reachability's answers against a search of the board
+ *
+ * Usage: reachcheck [steps] [seed]
+ *
+ * For each board size, random squares are blocked (when can_block() says
+ * they may be) and the newest ones unblocked again, the way GameEngine
+ * adds and removes opps and obstacles. Before each block every answer of
+ * can_block() is compared with a breadth-first search of the free squares
+ * with the square blocked, so a wrong join of the 8 squares around it, or
+ * a wrong undo, shows up as a mismatch. Small boards are checked the most,
+ * since that is where the edge group touches everything.
+ */
+
+#include "../../reachability.h"
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <vector>
+
+/*
+ * Function to check whether the free squares are all connected, moving
+ * left, right, up and down like the bee.
+ *
+ * @param walls holds 1 for each blocked square, row by row
+ */
+static bool connected(const std::vector<unsigned char>& walls, int n)
+{
+    int start = -1, free_squares = 0;
+    for(int i = 0; i < n*n; i++)
+    {
+        if(!walls[i])
+        {
+            free_squares++;
+            if(start < 0)
+                start = i;
+        }
+    }
+    if(free_squares == 0)
+        return true;
+
+    std::vector<unsigned char> seen(n*n, 0);
+    std::queue<int> next;
+    next.push(start);
+    seen[start] = 1;
+    int reached = 1;
+
+    static const int dx[] = { 1, -1, 0, 0 };
+    static const int dy[] = { 0, 0, 1, -1 };
+    while(!next.empty())
+    {
+        int at = next.front();
+        next.pop();
+        for(int d = 0; d < 4; d++)
+        {
+            int x = at % n + dx[d], y = at / n + dy[d];
+            if(x < 0 || y < 0 || x >= n || y >= n)
+                continue;
+            int to = y*n + x;
+            if(walls[to] || seen[to])
+                continue;
+            seen[to] = 1;
+            reached++;
+            next.push(to);
+        }
+    }
+    return reached == free_squares;
+}
+
+/*
+ * Function to play random blocks and unblocks on one board size.
+ *
+ * @param steps is how many blocks or unblocks to try
+ * @param checks and failures are added to
+ */
+static void check_board(int n, long steps, unsigned& random, long& checks, long& failures)
+{
+    Reachability reach(n);
+    std::vector<unsigned char> walls(n*n, 0);
+    std::vector<int> order; //blocked squares, newest last
+
+    for(long s = 0; s < steps; s++)
+    {
+        //a small LCG is plenty to pick squares
+        random = random*1103515245u + 12345u;
+        unsigned r = random >> 8;
+
+        //now and then start over, so boards get both full and empty
+        if(r % 997 == 0)
+        {
+            reach.clear();
+            walls.assign(n*n, 0);
+            order.clear();
+            continue;
+        }
+
+        //unblock the newest square a third of the time
+        if(!order.empty() && r % 3 == 0)
+        {
+            walls[order.back()] = 0;
+            order.pop_back();
+            reach.unblock_last();
+            continue;
+        }
+
+        int square = (r / 3) % (n*n);
+        int x = square % n, y = square / n;
+
+        bool expected = false;
+        if(!walls[square])
+        {
+            walls[square] = 1;
+            expected = connected(walls, n);
+            walls[square] = 0;
+        }
+
+        bool answer = reach.can_block(x, y);
+        checks++;
+        if(answer != expected || reach.blocked(x, y) != (walls[square] != 0))
+        {
+            if(failures < 10)
+                std::printf("%dx%d board, step %ld: can_block(%d,%d) is %d, search says %d\n",
+                            n, n, s, x, y, answer, expected);
+            failures++;
+        }
+
+        if(answer)
+        {
+            reach.block(x, y);
+            walls[square] = 1;
+            order.push_back(square);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    long steps = argc > 1 ? std::atol(argv[1]) : 400000;
+    unsigned random = argc > 2 ? unsigned(std::atoi(argv[2])) : 1;
+    if(steps < 1)
+    {
+        std::fprintf(stderr, "usage: reachcheck [steps] [seed]\n");
+        return 2;
+    }
+
+    //board sizes and the share of the steps each gets
+    static const int sizes[] = { 2, 3, 4, 5, 7, 10, 15, 20 };
+    static const int shares[] = { 1, 2, 2, 3, 3, 3, 3, 3 };
+    const int boards = sizeof(sizes) / sizeof(sizes[0]);
+    int total_shares = 0;
+    for(int b = 0; b < boards; b++)
+        total_shares += shares[b];
+
+    long checks = 0, failures = 0;
+    for(int b = 0; b < boards; b++)
+        check_board(sizes[b], steps*shares[b] / total_shares, random, checks, failures);
+
+    std::printf("%ld can_block answers checked: %ld wrong, %s\n", checks, failures, failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
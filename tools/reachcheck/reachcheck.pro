@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# Check of Reachability: blocks and unblocks random
+# squares and compares every can_block() answer with
+# a search of the board. Run by hand, it exits with
+# 1 if any answer is wrong.
+#
+#-------------------------------------------------
+
+TARGET = reachcheck
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+SOURCES += main.cpp \
+    ../../reachability.cpp
+
+HEADERS += ../../reachability.h
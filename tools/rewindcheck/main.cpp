@@ -0,0 +1,253 @@
+/*
+ * @file main.cpp
+ * @brief check that RewindBuffer gives back every tick it keeps exactly
+ *
+ * Usage: rewindcheck [games] [ticks]
+ *
+ * Seeded random games of each kind (easy, medium and hard on the menu, and
+ * a script that spawns enemies, steers them and keeps memory) are played
+ * for ticks ticks, starting over when a game ends. After every tick the
+ * newest tick is restored into a second engine and compared field by field
+ * with GameEngine::save of the game, and every 97 ticks and at the end all
+ * the kept ticks are. Each game is played twice: with the history the game
+ * gets (RewindBuffer::bytes_for), and with a small one that wraps round
+ * many times, so dropping the oldest keyframe is checked too. A small
+ * history must wrap at least once or the check fails.
+ */
+
+#include "../../rewind.h"
+#include "../../counterrng.h"
+#include "../../enemyscript.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const unsigned keyframe_every = 64;
+
+//every enemy spawns another now and then, changes course every few
+//ticks, and counts in its memory how long it has lived
+static const char* const spawn_script =
+        "mem = mem + 1\n"
+        "if mem % 7 == 0\n"
+        "    vx = random(3) - 1\n"
+        "    vy = random(3) - 1\n"
+        "end\n"
+        "if tick % 5 == 0\n"
+        "    spawn\n"
+        "end\n";
+
+struct GameKind
+{
+    const char* name;
+    size_t board_size;
+    int opp_time;
+    bool moving_enemies;
+    bool obstacles;
+    bool scripted;
+    size_t small_history; //bytes; wraps many times in a few thousand ticks
+};
+
+static const GameKind kinds[] =
+{
+    { "easy", 15, 5, false, false, false, 4096 },
+    { "medium", 15, 5, false, true, false, 4096 },
+    { "hard", 15, 5, true, true, false, 4096 },
+    { "hard 5x5", 5, 3, true, true, false, 2048 },
+    { "spawning", 30, 5, true, false, true, 1 << 16 },
+};
+
+struct Totals
+{
+    long ticks;
+    long checks;
+    long wraps;
+    long failures;
+};
+
+static bool same_cells(const std::vector<Cell>& a, const std::vector<Cell>& b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(size_t i = 0; i < a.size(); i++)
+    {
+        if(a[i].x != b[i].x || a[i].y != b[i].y)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Function to compare two snapshots.
+ *
+ * @return name of the first field that differs, or 0 if none does
+ */
+static const char* differs(const GameEngine::Snapshot& a, const GameEngine::Snapshot& b)
+{
+    if(a.bee.x != b.bee.x || a.bee.y != b.bee.y)
+        return "bee";
+    if(a.flower.x != b.flower.x || a.flower.y != b.flower.y)
+        return "flower";
+    if(!same_cells(a.opps, b.opps))
+        return "opps";
+    if(!same_cells(a.obstacles, b.obstacles))
+        return "obstacles";
+    if(!same_cells(a.clouds, b.clouds))
+        return "clouds";
+    if(!same_cells(a.cloud_velocities, b.cloud_velocities))
+        return "cloud_velocities";
+    if(a.cloud_behaviours != b.cloud_behaviours)
+        return "cloud_behaviours";
+    if(a.cloud_memory != b.cloud_memory)
+        return "cloud_memory";
+    if(a.counter != b.counter || a.score != b.score || a.num_opps != b.num_opps || a.progress != b.progress)
+        return "counters";
+    if(a.over != b.over)
+        return "over";
+    if(a.seed != b.seed || a.ticks != b.ticks || a.flowers_placed != b.flowers_placed || a.opps_placed != b.opps_placed)
+        return "random number counts";
+    return 0;
+}
+
+/*
+ * Function to make an engine for a kind of game, with the spawning script
+ * if the kind has it.
+ */
+static GameEngine* make_engine(const GameKind& kind, const EnemyScript& script, unsigned seed)
+{
+    GameEngine* engine = new GameEngine(kind.board_size, kind.opp_time, kind.moving_enemies, kind.obstacles, seed);
+    if(kind.scripted)
+    {
+        engine->set_enemy_behaviour(engine->add_behaviour(script));
+        engine->reset(seed);
+    }
+    return engine;
+}
+
+/*
+ * Function to restore one tick and compare it with what was saved.
+ */
+static void check_tick(RewindBuffer& history, uint64_t tick, const std::vector<GameEngine::Snapshot>& saved,
+                       GameEngine& restored, const char* game, Totals& totals)
+{
+    GameEngine::Snapshot got;
+    const char* field = "tick not kept";
+    if(history.restore(tick, restored))
+    {
+        restored.save(got);
+        field = differs(got, saved[tick]);
+    }
+
+    totals.checks++;
+    if(field)
+    {
+        if(totals.failures < 10)
+            std::printf("%s: tick %llu, %s differs\n", game, (unsigned long long)tick, field);
+        totals.failures++;
+    }
+}
+
+/*
+ * Function to play one game, recording it, and check what the history
+ * gives back.
+ *
+ * @param bytes is how big the history is
+ */
+static void check_game(const GameKind& kind, const EnemyScript& script, unsigned seed, long ticks, size_t bytes,
+                       Totals& totals)
+{
+    char game[64];
+    std::snprintf(game, sizeof(game), "%s seed %u, %zu byte history", kind.name, seed, bytes);
+
+    GameEngine* engine = make_engine(kind, script, seed);
+    GameEngine* restored = make_engine(kind, script, seed + 1);
+    RewindBuffer history(bytes, keyframe_every);
+    std::vector<GameEngine::Snapshot> saved;
+
+    uint64_t first = 0;
+    long wraps = 0;
+    for(long t = 0; t <= ticks; t++)
+    {
+        if(t > 0)
+        {
+            if(engine->is_over())
+                engine->reset(seed + unsigned(t));
+
+            CounterRng random(seed, CounterRng::Input, 0, t);
+            engine->press(static_cast<GameEngine::Move>(random.below(5)));
+            if(engine->has_moving_enemies())
+                engine->move_enemy();
+        }
+
+        history.record(*engine);
+        saved.push_back(GameEngine::Snapshot());
+        engine->save(saved.back());
+        totals.ticks++;
+
+        if(history.overflowed())
+        {
+            if(totals.failures < 10)
+                std::printf("%s: tick %ld too big for the history\n", game, t);
+            totals.failures++;
+            break;
+        }
+
+        if(history.first_tick() != first)
+        {
+            first = history.first_tick();
+            wraps++;
+        }
+
+        check_tick(history, history.last_tick(), saved, *restored, game, totals);
+        if(t % 97 == 0 || t == ticks)
+        {
+            for(uint64_t k = history.first_tick(); k <= history.last_tick(); k++)
+                check_tick(history, k, saved, *restored, game, totals);
+        }
+    }
+
+    if(bytes == kind.small_history && wraps == 0)
+    {
+        if(totals.failures < 10)
+            std::printf("%s: the history never wrapped round\n", game);
+        totals.failures++;
+    }
+    totals.wraps += wraps;
+
+    delete restored;
+    delete engine;
+}
+
+int main(int argc, char* argv[])
+{
+    long games = argc > 1 ? std::atol(argv[1]) : 4;
+    long ticks = argc > 2 ? std::atol(argv[2]) : 3000;
+    if(games < 1 || ticks < 1)
+    {
+        std::fprintf(stderr, "usage: rewindcheck [games] [ticks]\n");
+        return 2;
+    }
+
+    EnemyScript script;
+    std::string error;
+    if(!script.compile(spawn_script, error))
+    {
+        std::fprintf(stderr, "rewindcheck: script doesn't compile: %s\n", error.c_str());
+        return 2;
+    }
+
+    Totals totals = { 0, 0, 0, 0 };
+    for(size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++)
+    {
+        for(long g = 0; g < games; g++)
+        {
+            unsigned seed = unsigned(1000*k + g + 1);
+            check_game(kinds[k], script, seed, ticks, RewindBuffer::bytes_for(kinds[k].board_size), totals);
+            check_game(kinds[k], script, seed, ticks, kinds[k].small_history, totals);
+        }
+    }
+
+    std::printf("%ld ticks recorded, %ld restores checked, oldest keyframe dropped %ld times: %ld wrong, %s\n",
+                totals.ticks, totals.checks, totals.wraps, totals.failures, totals.failures ? "FAILED" : "ok");
+    return totals.failures ? 1 : 0;
+}
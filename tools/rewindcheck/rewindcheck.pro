@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Check of RewindBuffer: plays seeded random games,
+# restores the ticks it keeps and compares them with
+# what GameEngine saved, including after the history
+# wraps round. Run by hand, it exits with 1 if any
+# tick comes back different.
+#
+#-------------------------------------------------
+
+TARGET = rewindcheck
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+SOURCES += main.cpp \
+    ../../rewind.cpp \
+    ../../gameengine.cpp \
+    ../../enemyscript.cpp \
+    ../../reachability.cpp \
+    ../../trace.cpp \
+    ../../telemetry.cpp
+
+HEADERS += ../../rewind.h \
+    ../../gameengine.h \
+    ../../counterrng.h \
+    ../../enemyscript.h \
+    ../../reachability.h \
+    ../../trace.h \
+    ../../telemetry.h
@@ -0,0 +1,138 @@
+/*
+ * @file main.cpp
+ * @brief build tool that packs the board sprites into one atlas array
+ *
+ * Usage: spritepack <output.cpp> <sizes> name=image [name=image ...]
+ *
+ * sizes is a comma separated list of square sizes in pixels, for example
+ * 33,50. Every image is decoded, scaled to each size, converted to
+ * premultiplied ARGB and written to output.cpp as the array
+ * sprite_atlas_data, laid out as described in spriteatlas.h. An image given
+ * as name=image:native is packed once at its own size instead.
+ */
+
+#define SPRITEPACK_TOOL
+#include "../../spriteatlas.h"
+
+#include <QCoreApplication>
+#include <QImage>
+#include <QFile>
+#include <QStringList>
+#include <QByteArray>
+#include <QTextStream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/*
+ * Function to add a sprite's pixels to the end of the atlas, starting at a
+ * multiple of 16 bytes.
+ *
+ * @return offset of the pixels in the atlas
+ */
+static quint32 add_pixels(QByteArray& pixels, size_t start, const QImage& img)
+{
+    while((start + pixels.size()) % 16 != 0)
+        pixels.append('\0');
+
+    quint32 offset = start + pixels.size();
+    for(int y = 0; y < img.height(); y++)
+        pixels.append(reinterpret_cast<const char*>(img.constScanLine(y)), img.width()*4);
+    return offset;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    if(args.size() < 4)
+    {
+        std::fprintf(stderr, "usage: spritepack <output.cpp> <sizes> name=image[:native] ...\n");
+        return 1;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    QStringList size_list = args[2].split(',', Qt::SkipEmptyParts);
+#else
+    QStringList size_list = args[2].split(',', QString::SkipEmptyParts);
+#endif
+    std::vector<int> sizes;
+    foreach(const QString& s, size_list)
+        sizes.push_back(s.toInt());
+
+    //decode every image and scale it to every size
+    std::vector<SpriteAtlasEntry> table;
+    std::vector<QImage> images;
+    for(int i = 3; i < args.size(); i++)
+    {
+        QString name = args[i].section('=', 0, 0);
+        QString file = args[i].section('=', 1);
+        bool native = file.endsWith(":native");
+        if(native)
+            file.chop(7);
+
+        QImage img(file);
+        if(img.isNull() || name.toUtf8().size() >= int(sizeof(SpriteAtlasEntry().name)))
+        {
+            std::fprintf(stderr, "spritepack: can't read %s\n", qPrintable(file));
+            return 1;
+        }
+        img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        std::vector<int> wanted = sizes;
+        if(native)
+            wanted.assign(1, 0);
+
+        for(size_t k = 0; k < wanted.size(); k++)
+        {
+            QImage scaled = img;
+            if(wanted[k] > 0)
+                scaled = img.scaled(wanted[k], wanted[k], Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+            SpriteAtlasEntry e;
+            std::memset(&e, 0, sizeof(e));
+            std::strncpy(e.name, name.toUtf8().constData(), sizeof(e.name) - 1);
+            e.width = scaled.width();
+            e.height = scaled.height();
+            table.push_back(e);
+            images.push_back(scaled);
+        }
+    }
+
+    //header, table, then pixels
+    SpriteAtlasHeader header;
+    std::memcpy(header.magic, "BSPA", 4);
+    header.count = table.size();
+
+    size_t start = sizeof(header) + table.size()*sizeof(SpriteAtlasEntry);
+    QByteArray pixels;
+    for(size_t i = 0; i < table.size(); i++)
+        table[i].offset = add_pixels(pixels, start, images[i]);
+
+    QByteArray atlas;
+    atlas.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    atlas.append(reinterpret_cast<const char*>(table.data()), table.size()*sizeof(SpriteAtlasEntry));
+    atlas.append(pixels);
+
+    QFile out(args[1]);
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        std::fprintf(stderr, "spritepack: can't write %s\n", qPrintable(args[1]));
+        return 1;
+    }
+
+    QTextStream ts(&out);
+    ts << "// made by tools/spritepack, do not edit\n";
+    ts << "extern const unsigned char sprite_atlas_data[];\n";
+    ts << "alignas(16) const unsigned char sprite_atlas_data[" << atlas.size() << "] = {\n";
+    for(int i = 0; i < atlas.size(); i++)
+    {
+        ts << unsigned(static_cast<unsigned char>(atlas[i])) << ',';
+        if(i % 32 == 31)
+            ts << '\n';
+    }
+    ts << "\n};\n";
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Build tool that packs the board sprites into
+# spriteatlas_data.cpp. Built and run by hw4b.pro.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = spritepack
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+SOURCES += main.cpp
+
+HEADERS += ../../spriteatlas.h
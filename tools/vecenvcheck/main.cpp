@@ -0,0 +1,167 @@
+/*
+ * @file main.cpp
+ * @brief check that VecEnv plays the same games as GameEngine on its own
+ *
+ * Usage: vecenvcheck [games] [steps] [board_size]
+ *
+ * The same games are played three ways: on a VecEnv with one thread, on a
+ * VecEnv with several, and on plain GameEngines one after another, the way
+ * the bot server plays them. Every step the observations, rewards and dones
+ * have to match, including the step after a game ends, when VecEnv starts
+ * it over with a new seed. Observations are also checked against
+ * GameEngine::piece_at, so a piece the encoding missed is caught even if
+ * both VecEnvs miss it the same way.
+ */
+
+#include "../../vecenv.h"
+#include "../../counterrng.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//settings of the games, the same as hard on the start menu
+static const int opp_time = 5;
+static const bool moving_enemies = true;
+static const bool obstacles = true;
+static const unsigned seed = 1234;
+
+/*
+ * Function to write what a VecEnv observation of engine should be, from the
+ * engine's lists of pieces.
+ */
+static void expected_obs(const GameEngine& engine, uint8_t* obs)
+{
+    const size_t n = engine.get_board_size();
+    const size_t plane = n*n;
+    std::memset(obs, 0, VecEnv::obs_planes*plane);
+
+    obs[VecEnv::BeePlane*plane + engine.bee().y*n + engine.bee().x] = 1;
+    obs[VecEnv::HivePlane*plane + engine.hive().y*n + engine.hive().x] = 1;
+    obs[VecEnv::FlowerPlane*plane + engine.flower().y*n + engine.flower().x] = 1;
+    for(size_t k = 0; k < engine.opps().size(); k++)
+        obs[VecEnv::OppPlane*plane + engine.opps()[k].y*n + engine.opps()[k].x] = 1;
+    for(size_t k = 0; k < engine.obstacle_cells().size(); k++)
+        obs[VecEnv::ObstaclePlane*plane + engine.obstacle_cells()[k].y*n + engine.obstacle_cells()[k].x] = 1;
+    for(size_t k = 0; k < engine.clouds().size(); k++)
+        obs[VecEnv::CloudPlane*plane + engine.clouds()[k].y*n + engine.clouds()[k].x] = 1;
+}
+
+/*
+ * Function to check that every square piece_at draws has its plane set.
+ *
+ * @return false if one doesn't
+ */
+static bool matches_board(const GameEngine& engine, const uint8_t* obs)
+{
+    //plane of each GameEngine::Piece, -1 for Empty
+    static const int planes[] = { -1, VecEnv::CloudPlane, VecEnv::BeePlane, VecEnv::HivePlane,
+                                  VecEnv::OppPlane, VecEnv::ObstaclePlane, VecEnv::FlowerPlane };
+
+    const int n = int(engine.get_board_size());
+    for(int y = 0; y < n; y++)
+    {
+        for(int x = 0; x < n; x++)
+        {
+            int plane = planes[engine.piece_at(x, y)];
+            if(plane >= 0 && obs[(plane*n + y)*n + x] != 1)
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t games = argc > 1 ? std::atoi(argv[1]) : 64;
+    size_t steps = argc > 2 ? std::atoi(argv[2]) : 2000;
+    size_t board_size = argc > 3 ? std::atoi(argv[3]) : 15;
+    if(games < 1 || steps < 1 || board_size < 2)
+    {
+        std::fprintf(stderr, "usage: vecenvcheck [games] [steps] [board_size]\n");
+        return 2;
+    }
+
+    VecEnv one(games, board_size, opp_time, moving_enemies, obstacles, seed, 1);
+    VecEnv many(games, board_size, opp_time, moving_enemies, obstacles, seed, 4);
+
+    //the plain games, started over the way VecEnv::work does it
+    std::vector<GameEngine> plain;
+    std::vector<unsigned> episodes(games, 0);
+    for(size_t i = 0; i < games; i++)
+        plain.emplace_back(board_size, opp_time, moving_enemies, obstacles, seed + i);
+
+    const size_t obs_size = one.obs_size();
+    std::vector<uint8_t> obs_one(games*obs_size), obs_many(games*obs_size), expected(obs_size);
+    std::vector<float> rewards_one(games), rewards_many(games);
+    std::vector<uint8_t> dones_one(games), dones_many(games), actions(games);
+    std::vector<uint8_t> restart(games, 1);
+
+    one.reset(obs_one.data());
+    many.reset(obs_many.data());
+
+    size_t finished = 0, failures = 0;
+    for(size_t s = 0; s <= steps && failures < 10; s++)
+    {
+        //step 0 checks the observations reset() wrote
+        if(s > 0)
+        {
+            for(size_t i = 0; i < games; i++)
+                actions[i] = CounterRng(seed, CounterRng::Input, i, s).below(5);
+            one.step(actions.data(), obs_one.data(), rewards_one.data(), dones_one.data());
+            many.step(actions.data(), obs_many.data(), rewards_many.data(), dones_many.data());
+        }
+
+        for(size_t i = 0; i < games && failures < 10; i++)
+        {
+            GameEngine& engine = plain[i];
+            float reward = 0;
+            bool done = false;
+
+            if(restart[i])
+            {
+                episodes[i]++;
+                engine.reset(seed + i + episodes[i]*games);
+                restart[i] = 0;
+            }
+            if(s > 0)
+            {
+                size_t score = engine.get_score();
+                engine.press(static_cast<GameEngine::Move>(actions[i]));
+                if(engine.has_moving_enemies())
+                    engine.move_enemy();
+                reward = engine.is_over() ? -1.0f : float(engine.get_score() - score);
+                done = engine.is_over();
+                restart[i] = done;
+                finished += done;
+            }
+            engine.clear_changed();
+
+            expected_obs(engine, expected.data());
+            const uint8_t* got_one = obs_one.data() + i*obs_size;
+            const uint8_t* got_many = obs_many.data() + i*obs_size;
+
+            const char* problem = 0;
+            if(std::memcmp(got_one, expected.data(), obs_size) != 0)
+                problem = "one-thread observation";
+            else if(std::memcmp(got_many, expected.data(), obs_size) != 0)
+                problem = "many-thread observation";
+            else if(!matches_board(engine, expected.data()))
+                problem = "observation misses a piece";
+            else if(s > 0 && (rewards_one[i] != reward || rewards_many[i] != reward))
+                problem = "reward";
+            else if(s > 0 && (dones_one[i] != done || dones_many[i] != done))
+                problem = "done";
+
+            if(problem)
+            {
+                std::printf("game %u step %u: %s differs\n", unsigned(i), unsigned(s), problem);
+                failures++;
+            }
+        }
+    }
+
+    std::printf("%u games, %u steps, %u games finished and started over: %s\n",
+                unsigned(games), unsigned(steps), unsigned(finished), failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Check of VecEnv: plays the same games on a VecEnv
+# and on plain GameEngines and compares what each
+# step gives back. Run by hand, it exits with 1 if
+# anything differs.
+#
+#-------------------------------------------------
+
+TARGET = vecenvcheck
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+unix: LIBS += -lpthread
+
+SOURCES += main.cpp \
+    ../../vecenv.cpp \
+    ../../gameengine.cpp \
+    ../../enemyscript.cpp \
+    ../../reachability.cpp \
+    ../../trace.cpp \
+    ../../telemetry.cpp
+
+HEADERS += ../../vecenv.h \
+    ../../gameengine.h \
+    ../../counterrng.h \
+    ../../enemyscript.h \
+    ../../reachability.h \
+    ../../trace.h \
+    ../../telemetry.h
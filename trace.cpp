@@ -0,0 +1,224 @@
+/*
+ * @file trace.cpp
+ * @brief contains the trace recorder
+ *
+ * Every thread that records an event gets a ring buffer the first time it
+ * does. Only that thread writes to it; it publishes each event by bumping
+ * the buffer's head. When a thread ends its buffer is kept (so its events
+ * can still be written out) and handed to the next new thread.
+ */
+
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> enabled(false);
+
+namespace {
+
+const size_t ring_size = 1 << 16; //events kept per thread
+
+struct Event
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end; //same as start for instant events
+};
+
+struct Ring
+{
+    Event events[ring_size];
+    std::atomic<uint64_t> head; //number of events ever written
+    std::atomic<bool> in_use;
+    int tid;
+};
+
+std::mutex rings_lock;
+std::vector<Ring*> rings;
+std::string file_name;
+uint64_t start_time;
+
+/*
+ * Function to get a ring buffer for the calling thread, reusing one left
+ * behind by a thread that has ended if there is one.
+ */
+Ring* claim_ring()
+{
+    std::lock_guard<std::mutex> guard(rings_lock);
+
+    for(size_t i = 0; i < rings.size(); i++)
+    {
+        bool free = false;
+        if(rings[i]->in_use.compare_exchange_strong(free, true))
+            return rings[i];
+    }
+
+    Ring* r = new Ring;
+    r->head.store(0);
+    r->in_use.store(true);
+    r->tid = rings.size() + 1;
+    rings.push_back(r);
+    return r;
+}
+
+/*
+ * @struct Owner
+ * @brief gives a thread's ring buffer back when the thread ends
+ */
+struct Owner
+{
+    Ring* ring;
+    Owner() : ring(0) {}
+    ~Owner()
+    {
+        if(ring)
+            ring->in_use.store(false);
+    }
+};
+
+thread_local Owner owner;
+
+void push(const char* name, uint64_t start, uint64_t end)
+{
+    if(!owner.ring)
+        owner.ring = claim_ring();
+
+    Ring* r = owner.ring;
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    Event& e = r->events[h % ring_size];
+    e.name = name;
+    e.start = start;
+    e.end = end;
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void flush_at_exit()
+{
+    flush();
+}
+
+}
+
+/*
+ * Function to get the time in nanoseconds from a steady clock.
+ */
+uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Function to record an event that lasted from start_ns to end_ns.
+ */
+void record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+    push(name, start_ns, end_ns);
+}
+
+/*
+ * Function to record something that happened at one moment, like the
+ * game ending.
+ */
+void instant(const char* name)
+{
+    if(!enabled.load(std::memory_order_relaxed))
+        return;
+
+    uint64_t t = now_ns();
+    push(name, t, t);
+}
+
+/*
+ * Function to turn tracing on.
+ *
+ * @param name is the file flush() writes to
+ */
+void start(const char* name)
+{
+    {
+        std::lock_guard<std::mutex> guard(rings_lock);
+        file_name = name;
+        start_time = now_ns();
+    }
+
+    if(!enabled.exchange(true))
+        std::atexit(flush_at_exit);
+}
+
+/*
+ * Function to write every event still in the ring buffers to the trace
+ * file. A thread that is still running may overwrite its oldest events
+ * while they are being copied; those are left out rather than written
+ * half old and half new.
+ */
+void flush()
+{
+    if(!enabled.load())
+        return;
+
+    std::lock_guard<std::mutex> guard(rings_lock);
+
+    std::FILE* f = std::fopen(file_name.c_str(), "w");
+    if(!f)
+    {
+        std::perror("trace: can't write trace file");
+        return;
+    }
+
+    std::fputs("{\"traceEvents\":[\n", f);
+    bool first = true;
+    std::vector<Event> copy;
+
+    for(size_t i = 0; i < rings.size(); i++)
+    {
+        Ring* r = rings[i];
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t copied = head > ring_size ? head - ring_size : 0;
+
+        copy.resize(head - copied);
+        for(uint64_t k = copied; k < head; k++)
+            copy[k - copied] = r->events[k % ring_size];
+
+        //the thread may have moved on while copying. Event k's slot is
+        //written over by event k + ring_size, which can be in progress as
+        //soon as head reaches it, so only events after head - ring_size
+        //are sure to be whole
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t head_after = r->head.load(std::memory_order_relaxed);
+        uint64_t whole = head_after >= ring_size ? head_after - ring_size + 1 : 0;
+        uint64_t from = std::min(std::max(copied, whole), head);
+
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                     first ? "" : ",\n", r->tid, r->tid);
+        first = false;
+
+        for(uint64_t k = from; k < head; k++)
+        {
+            const Event& e = copy[k - copied];
+            if(e.start < start_time)
+                continue;
+
+            //times in microseconds from when tracing started
+            double ts = (e.start - start_time) / 1000.0;
+            if(e.end == e.start)
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                             e.name, ts, r->tid);
+            else
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                             e.name, ts, (e.end - e.start) / 1000.0, r->tid);
+        }
+    }
+
+    std::fputs("\n]}\n", f);
+    std::fclose(f);
+}
+
+}
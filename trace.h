@@ -0,0 +1,74 @@
+/*
+ * @file trace.h
+ * @brief header file to contain the trace recorder
+ *
+ * Records how long the game's handlers take so a slow frame can be looked
+ * at afterwards. Each thread writes its events into its own fixed-size ring
+ * buffer without locking, and flush() writes all of them to a JSON file in
+ * the Chrome trace event format, which chrome://tracing and Perfetto open.
+ *
+ * Tracing is off unless start() is called (main does this when the
+ * HW4B_TRACE environment variable holds a file name). When it is off, a
+ * TRACE_SCOPE costs one relaxed atomic load and a branch.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace trace {
+
+extern std::atomic<bool> enabled;
+
+//start recording; events are written to file_name by flush() and at exit
+void start(const char* file_name);
+
+//write everything recorded so far, keeps recording
+void flush();
+
+uint64_t now_ns();
+void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+void instant(const char* name);
+
+/*
+ * @class Scope
+ * @brief records one event lasting from construction to destruction
+ *
+ * name must be a string that lives for the whole program, such as a
+ * string literal.
+ */
+class Scope
+{
+public:
+    explicit Scope(const char* n) : name(0), start(0)
+    {
+        if(enabled.load(std::memory_order_relaxed))
+        {
+            name = n;
+            start = now_ns();
+        }
+    }
+
+    ~Scope()
+    {
+        if(name)
+            record(name, start, now_ns());
+    }
+
+private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+
+    const char* name;
+    uint64_t start;
+};
+
+}
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_JOIN(trace_scope_, __LINE__)(name)
+
+#endif // TRACE_H
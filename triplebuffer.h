@@ -0,0 +1,81 @@
+/*
+ * @file triplebuffer.h
+ * @brief header file to contain the TripleBuffer class template
+ *
+ * This headerfile contains the TripleBuffer class template, which passes
+ * the newest copy of something from one thread to another. The simulation
+ * thread uses it to hand each tick's state to GameBoard.
+*/
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * @class TripleBuffer
+ * @brief three copies of T: one being written, one being read, and the
+ * newest finished one in between
+ *
+ * The writer fills its copy and swaps it with the one in between; the
+ * reader swaps its copy with the one in between when there is a newer one.
+ * Neither ever waits for the other. The reader skips copies that were
+ * replaced before it looked, so it always gets the newest.
+ *
+ * Copies are reused, so a T holding vectors keeps their memory and stops
+ * allocating once the vectors have grown. middle, which both threads
+ * change, is padded onto its own cache line.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back_index(2), middle(1), front_index(0) {}
+
+    //copy the writer fills in; only the writing thread may use it
+    T& back() { return slots[back_index]; }
+
+    /*
+     * Function to hand the back copy to the reader. The writer gets the
+     * copy that was in between to fill in next.
+     */
+    void publish()
+    {
+        unsigned old = middle.exchange(back_index | Fresh, std::memory_order_acq_rel);
+        back_index = old & Index;
+    }
+
+    /*
+     * Function for the reader to take the newest published copy.
+     *
+     * @return false if nothing was published since the last call
+     */
+    bool update()
+    {
+        if(!(middle.load(std::memory_order_relaxed) & Fresh))
+            return false;
+
+        unsigned old = middle.exchange(front_index, std::memory_order_acq_rel);
+        front_index = old & Index;
+        return true;
+    }
+
+    //copy the reader has; only the reading thread may use it
+    const T& front() const { return slots[front_index]; }
+
+private:
+    enum { Index = 3, Fresh = 4 };
+
+    //see SpscQueue
+    static const size_t cache_line = 64;
+
+    T slots[3];
+    unsigned back_index; //only used by the writer
+    char pad_back[cache_line];
+    std::atomic<unsigned> middle; //slot in between, with Fresh set if it is new
+    char pad_middle[cache_line];
+    unsigned front_index; //only used by the reader
+};
+
+#endif // TRIPLEBUFFER_H
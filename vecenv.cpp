@@ -0,0 +1,221 @@
+/*
+ * @file vecenv.cpp
+ * @brief contains class definition of VecEnv class
+ *
+ * The games are split into equal chunks, one per thread. The calling thread
+ * does the first chunk itself and the worker threads, started once in the
+ * constructor, do the rest. Nothing is allocated once the games are built.
+ */
+
+#include "vecenv.h"
+#include <algorithm>
+#include <cstring>
+
+/*
+ * Constructor for the VecEnv class.
+ *
+ * @param num_envs is how many games to play at once
+ * @param board_sz, tm, moving_enem and obst are the GameEngine settings
+ * @param sd is the seed of the first game, each game gets its own seed after that
+ * @param num_threads is how many threads to use, 0 for one per core
+*/
+VecEnv::VecEnv(size_t num_envs, size_t board_sz, int tm, bool moving_enem, bool obst, unsigned sd, size_t num_threads) :
+    episodes(num_envs, 0), restart(num_envs, 0), board_size(board_sz), seed(sd),
+    cur_actions(0), cur_obs(0), cur_rewards(0), cur_dones(0), cur_reset(false),
+    generation(0), busy(0), stopping(false)
+{
+    envs.reserve(num_envs);
+    for(size_t i = 0; i < num_envs; i++)
+    {
+        envs.emplace_back(board_size, tm, moving_enem, obst, seed + i);
+        envs.back().clear_changed();
+    }
+
+    if(num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::min(num_threads, std::max<size_t>(num_envs, 1));
+
+    //the calling thread is worker 0
+    threads = num_threads;
+    for(size_t w = 1; w < threads; w++)
+        workers.emplace_back(&VecEnv::run, this, w);
+}
+
+/*
+ * Destructor for VecEnv class. Stops the worker threads.
+ */
+VecEnv::~VecEnv()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(size_t w = 0; w < workers.size(); w++)
+        workers[w].join();
+}
+
+/*
+ * Function run by each worker thread. Waits for a new step, does its chunk
+ * of the games, and tells the calling thread when it is finished.
+ *
+ * @param worker is the number of this thread, 1 to number of threads - 1
+ */
+void VecEnv::run(size_t worker)
+{
+    size_t seen = 0;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            start_cv.wait(guard, [&]{ return stopping || generation != seen; });
+            if(stopping)
+                return;
+            seen = generation;
+        }
+
+        work(envs.size()*worker/threads, envs.size()*(worker + 1)/threads);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if(--busy == 0)
+                done_cv.notify_one();
+        }
+    }
+}
+
+/*
+ * Function to wake the workers, do the first chunk of games on this thread,
+ * and wait for the workers to finish theirs.
+ */
+void VecEnv::dispatch()
+{
+    if(threads > 1)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            busy = threads - 1;
+            generation++;
+        }
+        start_cv.notify_all();
+    }
+
+    work(0, envs.size()/threads);
+
+    if(threads > 1)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        done_cv.wait(guard, [&]{ return busy == 0; });
+    }
+}
+
+/*
+ * Function to step (or reset) games first to last - 1 and write their
+ * observations.
+ */
+void VecEnv::work(size_t first, size_t last)
+{
+    for(size_t i = first; i < last; i++)
+    {
+        GameEngine& engine = envs[i];
+
+        //start a new game if this one is over or a reset was asked for
+        if(cur_reset || restart[i])
+        {
+            episodes[i]++;
+            engine.reset(seed + i + episodes[i]*envs.size());
+            engine.clear_changed();
+            restart[i] = 0;
+        }
+
+        if(!cur_reset)
+        {
+            size_t score = engine.get_score();
+
+            engine.press(static_cast<GameEngine::Move>(cur_actions[i]));
+            if(engine.has_moving_enemies())
+                engine.move_enemy();
+            engine.clear_changed();
+
+            //1 for dropping pollen at the hive, -1 for losing
+            float reward = float(engine.get_score() - score);
+            if(engine.is_over())
+                reward = -1.0f;
+
+            cur_rewards[i] = reward;
+            cur_dones[i] = engine.is_over();
+            restart[i] = engine.is_over();
+        }
+
+        write_obs(i, cur_obs + i*obs_size());
+    }
+}
+
+/*
+ * Function to write one game's planes. The buffer is cleared and then one
+ * byte set for each piece, so this costs the size of the board plus the
+ * number of pieces.
+ *
+ * @param i is the game
+ * @param obs is where the game's observation starts
+ */
+void VecEnv::write_obs(size_t i, uint8_t* obs) const
+{
+    const GameEngine& engine = envs[i];
+    const size_t plane = board_size*board_size;
+
+    std::memset(obs, 0, obs_size());
+
+    obs[BeePlane*plane + engine.bee().y*board_size + engine.bee().x] = 1;
+    obs[HivePlane*plane + engine.hive().y*board_size + engine.hive().x] = 1;
+    obs[FlowerPlane*plane + engine.flower().y*board_size + engine.flower().x] = 1;
+
+    const std::vector<Cell>& opps = engine.opps();
+    for(size_t k = 0, n = opps.size(); k < n; k++)
+        obs[OppPlane*plane + opps[k].y*board_size + opps[k].x] = 1;
+
+    const std::vector<Cell>& obstacles = engine.obstacle_cells();
+    for(size_t k = 0, n = obstacles.size(); k < n; k++)
+        obs[ObstaclePlane*plane + obstacles[k].y*board_size + obstacles[k].x] = 1;
+
+    const std::vector<Cell>& clouds = engine.clouds();
+    for(size_t k = 0, n = clouds.size(); k < n; k++)
+        obs[CloudPlane*plane + clouds[k].y*board_size + clouds[k].x] = 1;
+}
+
+/*
+ * Function to start every game over.
+ *
+ * @param obs receives size()*obs_size() bytes of observation
+ */
+void VecEnv::reset(uint8_t* obs)
+{
+    cur_reset = true;
+    cur_actions = 0;
+    cur_obs = obs;
+    cur_rewards = 0;
+    cur_dones = 0;
+
+    dispatch();
+}
+
+/*
+ * Function to move every game one tick. The bee makes its move and then
+ * the cloud moves once, like one tick of the bot server.
+ *
+ * @param actions holds a GameEngine::Move for each game
+ * @param obs receives size()*obs_size() bytes of observation
+ * @param rewards receives 1 for pollen dropped at the hive, -1 for a lost game
+ * @param dones receives 1 for each game that ended this step
+ */
+void VecEnv::step(const uint8_t* actions, uint8_t* obs, float* rewards, uint8_t* dones)
+{
+    cur_reset = false;
+    cur_actions = actions;
+    cur_obs = obs;
+    cur_rewards = rewards;
+    cur_dones = dones;
+
+    dispatch();
+}
@@ -0,0 +1,87 @@
+/*
+ * @file vecenv.h
+ * @brief header file to contain VecEnv class declarations
+ *
+ * This headerfile contains the class declaration of the VecEnv class, which
+ * plays many games at once for training bots. One call to step() moves every
+ * game one tick and writes all of their boards into a buffer the caller owns.
+ * It isn't part of the game itself; tools/vecenvcheck builds it and checks
+ * it against GameEngines played on their own.
+*/
+
+#ifndef VECENV_H
+#define VECENV_H
+
+#include "gameengine.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * @class VecEnv
+ * @brief steps N independent GameEngines together, split across threads
+ *
+ * Each game's observation is obs_planes planes of board_size*board_size
+ * bytes, one byte per square, 1 if the piece is there and 0 if not. The
+ * planes are in the order bee, hive, flower, opp, obstacle, cloud. Game i's
+ * observation starts at obs + i*obs_size().
+ *
+ * A game that finished on the last step starts over (with a new seed) at the
+ * start of the next step, so the finished board can still be read.
+ */
+class VecEnv
+{
+public:
+    enum Plane { BeePlane = 0, HivePlane, FlowerPlane, OppPlane, ObstaclePlane, CloudPlane };
+    static const size_t obs_planes = 6;
+
+    VecEnv(size_t num_envs, size_t board_size = 15, int opp_time = 5, bool moving_enemies = true, bool obstacles = true,
+           unsigned seed = 0, size_t num_threads = 0);
+    ~VecEnv();
+
+    //bytes of observation for one game
+    size_t obs_size() const { return obs_planes*board_size*board_size; }
+    size_t size() const { return envs.size(); }
+
+    //start every game over and write the first observations
+    void reset(uint8_t* obs);
+
+    //actions, rewards and dones hold one entry per game
+    void step(const uint8_t* actions, uint8_t* obs, float* rewards, uint8_t* dones);
+
+    const GameEngine& env(size_t i) const { return envs[i]; }
+
+private:
+    void dispatch();
+    void run(size_t worker);
+    void work(size_t first, size_t last);
+    void write_obs(size_t i, uint8_t* obs) const;
+
+    std::vector<GameEngine> envs;
+    std::vector<unsigned> episodes; //games started by each env, used for seeds
+    std::vector<uint8_t> restart; //whether the env finished on the last step
+    size_t board_size;
+    unsigned seed;
+
+    //arguments of the current call, read by the workers
+    const uint8_t* cur_actions;
+    uint8_t* cur_obs;
+    float* cur_rewards;
+    uint8_t* cur_dones;
+    bool cur_reset;
+
+    //worker threads wait for generation to change, then do their share
+    size_t threads; //including the calling thread
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    size_t generation;
+    size_t busy;
+    bool stopping;
+};
+
+#endif // VECENV_H